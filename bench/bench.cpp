@@ -0,0 +1,156 @@
+// Micro benchmarks of DSP building blocks of the plugin. Only the headers of the Rack SDK are
+// used, neither the engine nor the app are running. Every line of the output is
+// "<name>\t<ns per iteration>" so results can be compared between builds.
+//
+// Whole modules (CV-MAP, CV-PAM, MIDI-CAT with N mapped slots) are not benchmarked here. Their
+// process() resolves ParamHandles and pushes values through APP->engine, which needs libRack
+// and a running engine with the mapped modules added. Use the per-module profiler in the
+// context menu ("CPU profiling") for these, it measures inside a running patch.
+
+#include "rack.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+
+using namespace rack;
+
+#include "digital.hpp"
+#include "profiler.hpp"
+#include "ReMoveStorage.hpp"
+
+
+/** Prevents the compiler from dropping results of the benchmarks */
+static volatile float sink;
+
+
+template < typename F >
+static void bench(const char* name, int iterations, F f) {
+	// Warm up caches and branch predictors
+	for (int i = 0; i < iterations / 10; i++) f(i);
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) f(i);
+	auto end = std::chrono::steady_clock::now();
+	double ns = std::chrono::duration<double, std::nano>(end - start).count();
+	printf("%s\t%.3f\n", name, ns / iterations);
+}
+
+
+static void benchLinearFade() {
+	const float sampleTime = 1.f / 48000.f;
+
+	LinearFade fades[32];
+	for (int i = 0; i < 32; i++) fades[i].setRiseFall(0.01f, 0.02f);
+	bench("LinearFade[32].process", 1 << 20, [&](int n) {
+		// Retrigger one fade every 64 samples so rising, falling and idle fades are mixed
+		if ((n & 63) == 0) {
+			int i = (n >> 6) & 31;
+			if ((n >> 11) & 1) fades[i].triggerFadeOut(); else fades[i].triggerFadeIn();
+		}
+		float s = 0.f;
+		for (int i = 0; i < 32; i++) s += fades[i].process(sampleTime);
+		sink = s;
+	});
+
+	LinearFadeBank<32> bank;
+	bank.setRiseFall(0.01f, 0.02f);
+	alignas(16) float out[32];
+	bench("LinearFadeBank<32>.process", 1 << 20, [&](int n) {
+		if ((n & 63) == 0) {
+			int i = (n >> 6) & 31;
+			if ((n >> 11) & 1) bank.triggerFadeOut(i); else bank.triggerFadeIn(i);
+		}
+		bank.process(sampleTime, out);
+		sink = out[n & 31];
+	});
+}
+
+
+static void benchClockMultiplier() {
+	ClockMultiplier4 m;
+	// Four clocks with different periods and divisions
+	const int periods[4] = {4800, 6000, 9600, 12000};
+	const int divisions[4] = {3, 4, 7, 16};
+	int counter[4] = {};
+	bench("ClockMultiplier4.process", 1 << 22, [&](int n) {
+		int r = m.process();
+		for (int i = 0; i < 4; i++) {
+			if (++counter[i] < periods[i]) continue;
+			counter[i] = 0;
+			m.tick(i);
+			m.trigger(i, divisions[i]);
+		}
+		sink = (float)r;
+	});
+}
+
+
+static void benchReMove() {
+	using namespace ReMove;
+	const int lanes = 4;
+	const int length = REMOVE_MAX_DATA / lanes;
+
+	// Smooth movements on lanes 0 and 1, steps on lane 2 and a held value on lane 3
+	ReMoveStorage storage;
+	storage.setLanes(lanes);
+	for (int i = 0; i < length; i++) {
+		storage.reserve(0, i * lanes);
+		float* frame = storage.frame(0, i * lanes);
+		frame[0] = 0.5f + 0.5f * std::sin(i * 0.001f);
+		frame[1] = 0.5f + 0.4f * std::sin(i * 0.0003f) * std::cos(i * 0.00007f);
+		frame[2] = ((i / 2000) % 8) / 7.f;
+		frame[3] = 0.25f;
+	}
+
+	std::vector<uint8_t> buffer;
+	bench("ReMove.seqEncode", 16, [&](int n) {
+		buffer.clear();
+		for (int lane = 0; lane < lanes; lane++)
+			seqEncode(buffer, storage, 0, length, lanes, lane);
+		sink = buffer.size();
+	});
+	printf("ReMove.seqEncode.bytesPerSample\t%.3f\n", (double)buffer.size() / (length * lanes));
+
+	ReMoveStorage decoded;
+	decoded.setLanes(lanes);
+	bench("ReMove.seqDecode", 16, [&](int n) {
+		const uint8_t* p = buffer.data();
+		const uint8_t* end = p + buffer.size();
+		for (int lane = 0; lane < lanes; lane++)
+			sink = seqDecode(p, end, decoded, 0, lanes, lane);
+	});
+
+	for (int interpolation = INTERPOLATION_NONE; interpolation <= INTERPOLATION_CUBIC; interpolation++) {
+		static const char* names[] = {"ReMove.seqInterpolate.none", "ReMove.seqInterpolate.linear", "ReMove.seqInterpolate.cubic"};
+		bench(names[interpolation], 1 << 22, [&](int n) {
+			int i = (n & (length - 1)) * lanes;
+			int i0 = i > 0 ? i - lanes : i;
+			int i2 = std::min(i + lanes, (length - 1) * lanes);
+			int i3 = std::min(i + 2 * lanes, (length - 1) * lanes);
+			sink = seqInterpolate((INTERPOLATION)interpolation, storage.get(0, i0), storage.get(0, i), storage.get(0, i2), storage.get(0, i3), (n & 7) / 8.f);
+		});
+	}
+}
+
+
+static void benchProfiler() {
+	ProcessProfiler profiler;
+	// Durations spread over several half-octaves with an occasional outlier
+	bench("ProcessProfiler.record", 1 << 22, [&](int n) {
+		int64_t ns = 200 + (n & 1023) + ((n & 4095) == 0 ? 50000 : 0);
+		profiler.record(ProcessProfiler::SECTION_AUDIO, ns);
+	});
+	bench("ProcessProfiler.getPercentile99", 1 << 16, [&](int n) {
+		sink = profiler.getPercentile99(ProcessProfiler::SECTION_AUDIO);
+	});
+}
+
+
+int main(int argc, char* argv[]) {
+	const char* filter = argc > 1 ? argv[1] : "";
+	if (strstr("LinearFade", filter)) benchLinearFade();
+	if (strstr("ClockMultiplier", filter)) benchClockMultiplier();
+	if (strstr("ReMove", filter)) benchReMove();
+	if (strstr("ProcessProfiler", filter)) benchProfiler();
+	return 0;
+}
@@ -31,77 +31,202 @@ struct CVMapModule : CVMapModuleBase<MAX_CHANNELS> {
 	bool audioRate;
 	/** [Stored to Json] */
 	bool locked;
+	/** [Stored to Json] Size of the processing block in samples, 0 if disabled */
+	int blockSize;
+
+	/** Sample position within the current block */
+	int blockCounter = 0;
+	/** Ramp of each channel towards lastValue within the current block */
+	float rampValue[MAX_CHANNELS];
+	float rampDelta[MAX_CHANNELS];
+	/** Bitmask of ramping channels, for each block of four channels */
+	int rampActive[MAX_CHANNELS / 4];
 
 	dsp::ClockDivider processDivider;
 	dsp::ClockDivider lightDivider;
+	/** Revision of the plugin's profile the dividers have been set for */
+	int profileRevision = -1;
+
+	ProcessProfiler profiler;
 
 	CVMapModule() {
 		panelTheme = pluginSettings.panelThemeDefault;
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+		profiler.attach(this);
 		for (int i = 0; i < MAX_CHANNELS; i++) {
 			this->paramHandles[i].text = string::f("CV-MAP Ch%02d", i + 1);
 		}
-		processDivider.setDivision(32);
-		lightDivider.setDivision(1024);
+		applyProfile();
 		onReset();
 	}
 
 	void onReset() override {
 		audioRate = true;
 		locked = false;
+		setBlockSize(0);
 		CVMapModuleBase<MAX_CHANNELS>::onReset();
 	}
 
+	void setBlockSize(int blockSize) {
+		this->blockSize = blockSize;
+		blockCounter = 0;
+		for (int i = 0; i < MAX_CHANNELS / 4; i++) {
+			rampActive[i] = 0;
+		}
+	}
+
+	/** Sets the clock dividers according to the plugin's profile */
+	void applyProfile() {
+		profileRevision = pluginSettings.profileRevision;
+		processDivider.setDivision(pluginSettings.controlDivision(32));
+		lightDivider.setDivision(pluginSettings.lightDivision(1024));
+	}
+
 	void process(const ProcessArgs& args) override {
-		if (audioRate || processDivider.process()) {
-			// Step channels
-			for (int i = 0; i < mapLen; i++) {
+		if (profileRevision != pluginSettings.profileRevision)
+			applyProfile();
+		int64_t profileStart = profiler.begin();
+		if (blockSize > 0)
+			processBlockRate();
+		else
+			processSlots();
+		profiler.end(ProcessProfiler::SECTION_CONTROL, profileStart);
+
+		// Set channel lights infrequently
+		if (lightDivider.process()) {
+			int64_t profileStart = profiler.begin();
+			for (int c = 0; c < 16; c++) {
+				bool active = (c < inputs[POLY_INPUT1].getChannels());
+				lights[CHANNEL_LIGHTS1 + c].setBrightness(active);
+			}
+			for (int c = 0; c < 16; c++) {
+				bool active = (c < inputs[POLY_INPUT2].getChannels());
+				lights[CHANNEL_LIGHTS2 + c].setBrightness(active);
+			}
+			profiler.end(ProcessProfiler::SECTION_LIGHT, profileStart);
+		}
+		
+		CVMapModuleBase<MAX_CHANNELS>::process(args);
+	}
+
+	inline void processSlots() {
+		stepSlotScheduler(audioRate ? 1 : processDivider.getDivision());
+		// Step channels in blocks of four
+		for (int i = 0; i < mapLen; i += 4) {
+			int port = i < 16 ? POLY_INPUT1 : POLY_INPUT2;
+			int c = i % 16;
+			int channels = inputs[port].getChannels() - c;
+			if (channels <= 0) {
+				// Skip unused channels on INPUT1
 				if (i < 16) {
+					i = 12;
+					continue;
+				}
+				// Skip unused channels on INPUT2
+				break;
+			}
+
+			// Bitmask of lanes which are in use, due for an update and mapped to a parameter
+			int mapped = 0;
+			for (int j = 0; j < 4 && j < channels && i + j < mapLen; j++) {
+				if (slotDue(i + j) && getParamQuantity(i + j) != NULL) mapped |= 1 << j;
+			}
+			if (mapped == 0) continue;
+
+			simd::float_4 v = simd::float_4::load(inputs[port].getVoltages(c));
+			if (bipolarInput)
+				v += 5.f;
+			v = v / 10.f;
+
+			simd::float_4 last = simd::float_4::load(&lastValue[i]);
+			// If lastValue is unitialized set it to its current value, only executed once
+			int init = simd::movemask(last == UINIT) & mapped;
+			int changed = lockParameterChanges ? mapped : simd::movemask(last != v) & mapped & ~init;
+
+			for (int j = 0; j < 4; j++) {
+				if (!((init | changed) & (1 << j))) continue;
+				// Set ParamQuantity
+				if (changed & (1 << j))
+					paramHandleCache[i + j].paramQuantity->setScaledValue(v[j]);
+				lastValue[i + j] = v[j];
+			}
+		}
+	}
+
+	/** Evaluates the inputs once per block and ramps the parameters linearly towards them */
+	inline void processBlockRate() {
+		if (blockCounter == 0) {
+			for (int i = 0; i < mapLen; i += 4) {
+				rampActive[i / 4] = 0;
+				int port = i < 16 ? POLY_INPUT1 : POLY_INPUT2;
+				int c = i % 16;
+				int channels = inputs[port].getChannels() - c;
+				if (channels <= 0) {
 					// Skip unused channels on INPUT1
-					if (inputs[POLY_INPUT1].getChannels() == i) {
-						i = 15;
+					if (i < 16) {
+						i = 12;
 						continue;
 					}
-				} else {
 					// Skip unused channels on INPUT2
-					if (inputs[POLY_INPUT2].getChannels() == i - 16) {
-						break;
-					}
+					break;
 				}
 
-				ParamQuantity *paramQuantity = getParamQuantity(i);
-				if (paramQuantity == NULL) continue;
-				// Set ParamQuantity
-				float v = i < 16 ? inputs[POLY_INPUT1].getVoltage(i) : inputs[POLY_INPUT2].getVoltage(i - 16);
+				int mapped = 0;
+				for (int j = 0; j < 4 && j < channels && i + j < mapLen; j++) {
+					if (getParamQuantity(i + j) != NULL) mapped |= 1 << j;
+				}
+				if (mapped == 0) continue;
+
+				simd::float_4 v = simd::float_4::load(inputs[port].getVoltages(c));
 				if (bipolarInput)
 					v += 5.f;
-				v = rescale(v, 0.f, 10.f, 0.f, 1.f);
+				v = v / 10.f;
 
+				simd::float_4 last = simd::float_4::load(&lastValue[i]);
 				// If lastValue is unitialized set it to its current value, only executed once
-				if (lastValue[i] == UINIT) {
-					lastValue[i] = v;
-				}
-
-				if (lockParameterChanges || lastValue[i] != v) {
-					paramQuantity->setScaledValue(v);
-					lastValue[i] = v;
+				int init = simd::movemask(last == UINIT) & mapped;
+				int changed = simd::movemask(last != v) & mapped & ~init;
+
+				last.store(&rampValue[i]);
+				((v - last) / blockSize).store(&rampDelta[i]);
+				rampActive[i / 4] = changed;
+
+				for (int j = 0; j < 4; j++) {
+					if (!(mapped & (1 << j))) continue;
+					// Hold unchanged parameters once per block
+					if (lockParameterChanges && !(changed & (1 << j)) && !(init & (1 << j)))
+						paramHandleCache[i + j].paramQuantity->setScaledValue(v[j]);
+					lastValue[i + j] = v[j];
 				}
 			}
 		}
 
-		// Set channel lights infrequently
-		if (lightDivider.process()) {
-			for (int c = 0; c < 16; c++) {
-				bool active = (c < inputs[POLY_INPUT1].getChannels());
-				lights[CHANNEL_LIGHTS1 + c].setBrightness(active);
+		blockCounter++;
+		bool blockEnd = blockCounter >= blockSize;
+		// Step the ramps, one add per active channel
+		for (int i = 0; i < mapLen; i += 4) {
+			int active = rampActive[i / 4];
+			if (active == 0) continue;
+			simd::float_4 r = simd::float_4::load(&rampValue[i]) + simd::float_4::load(&rampDelta[i]);
+			// Land exactly on the target at the end of the block
+			if (blockEnd)
+				r = simd::float_4::load(&lastValue[i]);
+			r.store(&rampValue[i]);
+
+			for (int j = 0; j < 4; j++) {
+				if (!(active & (1 << j))) continue;
+				ParamQuantity* paramQuantity = getParamQuantity(i + j);
+				if (paramQuantity)
+					paramQuantity->setScaledValue(r[j]);
 			}
-			for (int c = 0; c < 16; c++) {
-				bool active = (c < inputs[POLY_INPUT2].getChannels());
-				lights[CHANNEL_LIGHTS2 + c].setBrightness(active);
+		}
+
+		if (blockEnd) {
+			blockCounter = 0;
+			for (int i = 0; i < MAX_CHANNELS / 4; i++) {
+				rampActive[i] = 0;
 			}
 		}
-		
-		CVMapModuleBase<MAX_CHANNELS>::process(args);
 	}
 
 	json_t* dataToJson() override {
@@ -109,6 +234,7 @@ struct CVMapModule : CVMapModuleBase<MAX_CHANNELS> {
 		json_object_set_new(rootJ, "panelTheme", json_integer(panelTheme));
 		json_object_set_new(rootJ, "audioRate", json_boolean(audioRate));
 		json_object_set_new(rootJ, "locked", json_boolean(locked));
+		json_object_set_new(rootJ, "blockSize", json_integer(blockSize));
 		return rootJ;
 	}
 
@@ -120,6 +246,8 @@ struct CVMapModule : CVMapModuleBase<MAX_CHANNELS> {
 		if (audioRateJ) audioRate = json_boolean_value(audioRateJ);
 		json_t* lockedJ = json_object_get(rootJ, "locked");
 		if (lockedJ) locked = json_boolean_value(lockedJ);
+		json_t* blockSizeJ = json_object_get(rootJ, "blockSize");
+		if (blockSizeJ) setBlockSize(json_integer_value(blockSizeJ));
 	}
 };
 
@@ -145,7 +273,7 @@ struct CVMapWidget : ThemedModuleWidget<CVMapModule> {
 		w1->setModule(module, CVMapModule::CHANNEL_LIGHTS2);
 		addChild(w1);
 
-		typedef MapModuleDisplay<MAX_CHANNELS, CVMapModule> TMapDisplay;
+		typedef MapModuleDisplay<MAX_CHANNELS, CVMapModule, MapModuleSlotRateChoice<MAX_CHANNELS, CVMapModule>> TMapDisplay;
 		TMapDisplay* mapWidget = createWidget<TMapDisplay>(Vec(10.6f, 81.5f));
 		mapWidget->box.size = Vec(128.9f, 261.7f);
 		mapWidget->setModule(module);
@@ -197,6 +325,35 @@ struct CVMapWidget : ThemedModuleWidget<CVMapModule> {
 			}
 		};
 
+		struct BlockSizeMenuItem : MenuItem {
+			CVMapModule* module;
+			BlockSizeMenuItem() {
+				rightText = RIGHT_ARROW;
+			}
+
+			Menu* createChildMenu() override {
+				struct BlockSizeItem : MenuItem {
+					CVMapModule* module;
+					int blockSize;
+					void onAction(const event::Action& e) override {
+						module->setBlockSize(blockSize);
+					}
+					void step() override {
+						rightText = module->blockSize == blockSize ? "✔" : "";
+						MenuItem::step();
+					}
+				};
+
+				Menu* menu = new Menu;
+				menu->addChild(construct<BlockSizeItem>(&MenuItem::text, "Off", &BlockSizeItem::module, module, &BlockSizeItem::blockSize, 0));
+				menu->addChild(construct<BlockSizeItem>(&MenuItem::text, "16 samples", &BlockSizeItem::module, module, &BlockSizeItem::blockSize, 16));
+				menu->addChild(construct<BlockSizeItem>(&MenuItem::text, "32 samples", &BlockSizeItem::module, module, &BlockSizeItem::blockSize, 32));
+				menu->addChild(construct<BlockSizeItem>(&MenuItem::text, "64 samples", &BlockSizeItem::module, module, &BlockSizeItem::blockSize, 64));
+				menu->addChild(construct<BlockSizeItem>(&MenuItem::text, "128 samples", &BlockSizeItem::module, module, &BlockSizeItem::blockSize, 128));
+				return menu;
+			}
+		};
+
 		struct TextScrollItem : MenuItem {
 			CVMapModule* module;
 
@@ -240,6 +397,7 @@ struct CVMapWidget : ThemedModuleWidget<CVMapModule> {
 		menu->addChild(construct<LockItem>(&MenuItem::text, "Parameter changes", &LockItem::module, module));
 		menu->addChild(construct<UniBiItem>(&MenuItem::text, "Signal input", &UniBiItem::module, module));
 		menu->addChild(construct<AudioRateItem>(&MenuItem::text, "Audio rate processing", &AudioRateItem::module, module));
+		menu->addChild(construct<BlockSizeMenuItem>(&MenuItem::text, "Block processing with ramps", &BlockSizeMenuItem::module, module));
 		menu->addChild(new MenuSeparator());
 		menu->addChild(construct<TextScrollItem>(&MenuItem::text, "Text scrolling", &TextScrollItem::module, module));
 		menu->addChild(construct<MappingIndicatorHiddenItem>(&MenuItem::text, "Hide mapping indicators", &MappingIndicatorHiddenItem::module, module));
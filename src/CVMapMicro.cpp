@@ -11,29 +11,12 @@ static const float UINIT = 0;
 template < typename MODULE >
 struct MapParamQuantity : ParamQuantity {
 	MODULE* module;
+	ParamNameCache paramNameCache;
+
 	std::string getParamName() {
 		if (!module)
 			return "";
-		ParamHandle* paramHandle = &module->paramHandles[0];
-		if (paramHandle->moduleId < 0)
-			return "";
-		ModuleWidget* mw = APP->scene->rack->getModule(paramHandle->moduleId);
-		if (!mw)
-			return "";
-		// Get the Module from the ModuleWidget instead of the ParamHandle.
-		// I think this is more elegant since this method is called in the app world instead of the engine world.
-		Module* m = mw->module;
-		if (!m)
-			return "";
-		int paramId = paramHandle->paramId;
-		if (paramId >= (int) m->params.size())
-			return "";
-		ParamQuantity* paramQuantity = m->paramQuantities[paramId];
-		std::string s;
-		s += mw->model->name;
-		s += " ";
-		s += paramQuantity->label;
-		return s;
+		return paramNameCache.get(&module->paramHandles[0]);
 	}
 
 	std::string getDisplayValueString() override {
@@ -32,20 +32,33 @@ struct CVPamModule : MapModuleBase<MAX_CHANNELS> {
 	bool audioRate;
 	/** [Stored to Json] */
 	bool locked;
+
+	/** Snapshot of the last scaled value of each channel */
+	float lastValue[MAX_CHANNELS];
+	/** Bitmask of channels which have changed and whose filters have not settled yet */
+	uint32_t dirty;
+	/** The smoothing processor of each channel, four channels per filter */
+	dsp::TExponentialFilter<simd::float_4> valueFilters4[MAX_CHANNELS / 4];
+
+	int lastMapLen = -1;
+	bool lastBipolarOutput = false;
 	
 	dsp::ClockDivider processDivider;
 	dsp::ClockDivider lightDivider;
+	int profileRevision = -1;
+
+	ProcessProfiler profiler;
 
 	CVPamModule() {
 		panelTheme = pluginSettings.panelThemeDefault;
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+		profiler.attach(this);
 		this->mappingIndicatorColor = nvgRGB(0x40, 0xff, 0xff);
 		for (int id = 0; id < MAX_CHANNELS; id++) {
 			paramHandles[id].text = string::f("CV-PAM Ch%02d", id + 1);
 		}
 		onReset();
-		processDivider.setDivision(32);
-		lightDivider.setDivision(1024);
+		applyProfile();
 	}
 
 	void onReset() override {
@@ -53,38 +66,71 @@ struct CVPamModule : MapModuleBase<MAX_CHANNELS> {
 		audioRate = true;
 		locked = false;
 		MapModuleBase<MAX_CHANNELS>::onReset();
+		for (int id = 0; id < MAX_CHANNELS; id++) {
+			lastValue[id] = 0.f;
+		}
+		for (int i = 0; i < MAX_CHANNELS / 4; i++) {
+			valueFilters4[i].reset();
+		}
+		dirty = 0xffffffff;
+	}
+
+	void applyProfile() {
+		profileRevision = pluginSettings.profileRevision;
+		processDivider.setDivision(pluginSettings.controlDivision(32));
+		lightDivider.setDivision(pluginSettings.lightDivision(1024));
 	}
 
 	void process(const ProcessArgs& args) override {
-		if (audioRate || processDivider.process()) {
-			int lastChannel_out1 = -1;
-			int lastChannel_out2 = -1;
-
-			// Step channels
-			for (int id = 0; id < mapLen; id++) {
-				lastChannel_out1 = id < 16 ? id : lastChannel_out1;
-				lastChannel_out2 = id >= 16 ? id - 16 : lastChannel_out2;
-				
-				ParamQuantity* paramQuantity = getParamQuantity(id);
-				if (paramQuantity == NULL) continue;
-				// set voltage
-				float v = paramQuantity->getScaledValue();
-				v = valueFilters[id].process(args.sampleTime, v);
-				v = rescale(v, 0.f, 1.f, 0.f, 10.f);
-				if (bipolarOutput)
-					v -= 5.f;
-				if (id < 16) 
-					outputs[POLY_OUTPUT1].setVoltage(v, id); 
-				else 
-					outputs[POLY_OUTPUT2].setVoltage(v, id - 16);
+		if (profileRevision != pluginSettings.profileRevision)
+			applyProfile();
+		int64_t profileStart = profiler.begin();
+		stepSlotScheduler(audioRate ? 1 : processDivider.getDivision());
+		// Step channels, only changed parameters are marked for filtering and output
+		for (int id = 0; id < mapLen; id++) {
+			if (!slotDue(id)) continue;
+			ParamQuantity* paramQuantity = getParamQuantity(id);
+			if (paramQuantity == NULL) continue;
+			ParamHandleCache* cache = &paramHandleCache[id];
+			float v = rescale(paramQuantity->getValue(), cache->minValue, cache->maxValue, 0.f, 1.f);
+			if (v != lastValue[id]) {
+				lastValue[id] = v;
+				dirty |= 1u << id;
 			}
-			
-			outputs[POLY_OUTPUT1].setChannels(lastChannel_out1 + 1);
-			outputs[POLY_OUTPUT2].setChannels(lastChannel_out2 + 1);
 		}
+		profiler.end(ProcessProfiler::SECTION_CONTROL, profileStart);
+		profileStart = profiler.begin();
+
+		// Rewrite all channels if the number of channels or the output range has changed
+		if (mapLen != lastMapLen || bipolarOutput != lastBipolarOutput) {
+			lastMapLen = mapLen;
+			lastBipolarOutput = bipolarOutput;
+			dirty = 0xffffffff;
+		}
+
+		// Filter and set voltages of channels in blocks of four, settled blocks are skipped
+		for (int i = 0; dirty != 0 && i < MAX_CHANNELS / 4; i++) {
+			uint32_t blockDirty = (dirty >> (i * 4)) & 0xf;
+			if (blockDirty == 0) continue;
+			simd::float_4 in = simd::float_4::load(&lastValue[i * 4]);
+			simd::float_4 v = valueFilters4[i].process(args.sampleTime, in);
+			uint32_t settled = simd::movemask(v == in);
+			dirty &= ~(settled << (i * 4));
+
+			v = v * 10.f;
+			if (bipolarOutput)
+				v -= 5.f;
+			int port = i < 4 ? POLY_OUTPUT1 : POLY_OUTPUT2;
+			v.store(outputs[port].getVoltages((i % 4) * 4));
+		}
+
+		outputs[POLY_OUTPUT1].setChannels(std::min(mapLen, 16));
+		outputs[POLY_OUTPUT2].setChannels(std::max(mapLen - 16, 0));
+		profiler.end(ProcessProfiler::SECTION_AUDIO, profileStart);
 
 		// Set channel lights infrequently
 		if (lightDivider.process()) {
+			int64_t profileStart = profiler.begin();
 			for (int c = 0; c < 16; c++) {
 				bool active = (c < outputs[POLY_OUTPUT1].getChannels());
 				lights[CHANNEL_LIGHTS1 + c].setBrightness(active);
@@ -93,6 +139,7 @@ struct CVPamModule : MapModuleBase<MAX_CHANNELS> {
 				bool active = (c < outputs[POLY_OUTPUT2].getChannels());
 				lights[CHANNEL_LIGHTS2 + c].setBrightness(active);
 			}
+			profiler.end(ProcessProfiler::SECTION_LIGHT, profileStart);
 		}
 
 		MapModuleBase::process(args);
@@ -117,6 +164,7 @@ struct CVPamModule : MapModuleBase<MAX_CHANNELS> {
 		if (audioRateJ) audioRate = json_boolean_value(audioRateJ);
 		json_t* lockedJ = json_object_get(rootJ, "locked");
 		if (lockedJ) locked = json_boolean_value(lockedJ);
+		dirty = 0xffffffff;
 	}
 };
 
@@ -142,7 +190,7 @@ struct CVPamWidget : ThemedModuleWidget<CVPamModule> {
 		w1->setModule(module, CVPamModule::CHANNEL_LIGHTS2);
 		addChild(w1);
 
-		typedef MapModuleDisplay<MAX_CHANNELS, CVPamModule> TMapDisplay;
+		typedef MapModuleDisplay<MAX_CHANNELS, CVPamModule, MapModuleSlotRateChoice<MAX_CHANNELS, CVPamModule>> TMapDisplay;
 		TMapDisplay* mapWidget = createWidget<TMapDisplay>(Vec(10.6f, 81.5f));
 		mapWidget->box.size = Vec(128.9f, 261.7f);
 		mapWidget->setModule(module);
@@ -1,11 +1,71 @@
 #include "plugin.hpp"
-#include "MapModuleBase.hpp"
 
 namespace Grip {
 
-static const int MAX_CHANNELS = 32;
+static const int BLOCK_SIZE = 32;
+static const int MAX_BLOCKS = 64;
+
+/** A block of pinned parameters, blocks are never moved as the engine holds pointers to the handles */
+struct GripBlock {
+	ParamHandle paramHandles[BLOCK_SIZE];
+	/** Whether the param handle is registered with the engine */
+	bool paramHandleRegistered[BLOCK_SIZE];
+	/** [Stored to JSON] Pinned value of each slot, scaled between 0 and 1 */
+	float lastValue[BLOCK_SIZE];
+
+	/** Resolved target of each slot, revalidated against ParamHandle::module */
+	bool resolved[BLOCK_SIZE];
+	Module* modules[BLOCK_SIZE];
+	ParamQuantity* paramQuantities[BLOCK_SIZE];
+	/** Points to the value of the target parameter, or to the pinned value if the slot is unresolved */
+	float* values[BLOCK_SIZE];
+	/** Pinned value of each slot as the target parameter actually stores it */
+	alignas(16) float pinnedValues[BLOCK_SIZE];
+	alignas(16) float currentValues[BLOCK_SIZE];
+
+	GripBlock() {
+		for (int i = 0; i < BLOCK_SIZE; i++) {
+			paramHandles[i].text = "stoermelder GRIP";
+			paramHandles[i].color = nvgRGB(0xcd, 0x5c, 0x5c);
+			paramHandleRegistered[i] = false;
+			lastValue[i] = -1.f;
+			currentValues[i] = 0.f;
+			invalidate(i);
+		}
+	}
+
+	void resolve(int i) {
+		resolved[i] = true;
+		modules[i] = paramHandles[i].module;
+		paramQuantities[i] = NULL;
+		values[i] = &pinnedValues[i];
+		pinnedValues[i] = 0.f;
+		if (!modules[i])
+			return;
+		int paramId = paramHandles[i].paramId;
+		ParamQuantity* paramQuantity = modules[i]->paramQuantities[paramId];
+		if (!paramQuantity)
+			return;
+		if (!paramQuantity->isBounded())
+			return;
+		paramQuantities[i] = paramQuantity;
+		values[i] = &modules[i]->params[paramId].value;
+		// Write the pin once and keep the value the parameter settles at, as rescaling and
+		// snapping would otherwise leave it deviating from the pin forever
+		paramQuantity->setScaledValue(lastValue[i]);
+		pinnedValues[i] = *values[i];
+	}
+
+	void invalidate(int i) {
+		resolved[i] = false;
+		modules[i] = NULL;
+		paramQuantities[i] = NULL;
+		pinnedValues[i] = 0.f;
+		values[i] = &pinnedValues[i];
+	}
+};
 
-struct GripModule : CVMapModuleBase<MAX_CHANNELS> {
+struct GripModule : Module {
 	enum ParamIds {
 		PARAM_BIND,
 		NUM_PARAMS
@@ -23,110 +83,288 @@ struct GripModule : CVMapModuleBase<MAX_CHANNELS> {
 
 	/** [Stored to JSON] */
 	int panelTheme = 0;
-	/** [Stored to Json] */
+	/** [Stored to Json] Check pinned parameters on every sample */
 	bool audioRate;
+	/** [Stored to JSON] */
+	bool mappingIndicatorHidden = false;
+
+	/** Growable pool of slots, only the first blockLen blocks are allocated */
+	GripBlock* blocks[MAX_BLOCKS];
+	int blockLen = 0;
+	/** Number of slots up to the last mapped one */
+	int mapLen = 0;
+
+	/** Slot ID of the learning session */
+	int learningId = -1;
 
 	dsp::ClockDivider processDivider;
 	dsp::ClockDivider lightDivider;
+	int profileRevision = -1;
+
+	ProcessProfiler profiler;
+
+	/** Sample counter for spreading the groups of four slots across samples */
+	uint32_t slotCounter = 0;
 
 	GripModule() {
 		panelTheme = pluginSettings.panelThemeDefault;
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
 		configParam<TriggerParamQuantity>(PARAM_BIND, 0.f, 1.f, 0.f, "Bind new parameter");
-		processDivider.setDivision(64);
-		lightDivider.setDivision(1024);
+		profiler.attach(this);
+		applyProfile();
 
-		for (int i = 0; i < MAX_CHANNELS; i++) {
-			paramHandles[i].text = "stoermelder GRIP";
-			paramHandles[i].color = color::fromHexString("#CD5C5C");
+		for (int i = 0; i < MAX_BLOCKS; i++) {
+			blocks[i] = NULL;
 		}
+		allocateBlock();
+		mappingRegistry.registerOwner(this);
 
 		onReset();
 	}
 
+	~GripModule() {
+		mappingRegistry.unregisterOwner(this);
+		for (int b = 0; b < blockLen; b++) {
+			GripBlock* block = blocks[b];
+			for (int i = 0; i < BLOCK_SIZE; i++) {
+				if (block->paramHandleRegistered[i])
+					APP->engine->removeParamHandle(&block->paramHandles[i]);
+			}
+			delete block;
+		}
+	}
+
 	void onReset() override {
 		audioRate = false;
-		CVMapModuleBase<MAX_CHANNELS>::onReset();
+		clearMaps();
+	}
+
+	void applyProfile() {
+		profileRevision = pluginSettings.profileRevision;
+		processDivider.setDivision(pluginSettings.controlDivision(64));
+		lightDivider.setDivision(pluginSettings.lightDivision(1024));
 	}
 
 	void process(const ProcessArgs& args) override {
-		if (audioRate || processDivider.process()) {
-			// Step channels
-			for (int i = 0; i < mapLen; i++) {
-				ParamQuantity* paramQuantity = getParamQuantity(i);
-				if (paramQuantity == NULL) continue;
-
-				// Set ParamQuantity
-				paramQuantity->setScaledValue(lastValue[i]);
-			}
+		if (profileRevision != pluginSettings.profileRevision)
+			applyProfile();
+		// Each group of four slots is due once per division, groups are offset by their index
+		// so the work per sample stays flat, division is always a power of two
+		int64_t profileStart = profiler.begin();
+		slotCounter++;
+		uint32_t division = audioRate ? 1 : processDivider.getDivision();
+		for (int b = 0; b * BLOCK_SIZE < mapLen; b++) {
+			processBlock(blocks[b], std::min(mapLen - b * BLOCK_SIZE, BLOCK_SIZE), slotCounter + b * (BLOCK_SIZE / 4), division);
 		}
+		profiler.end(ProcessProfiler::SECTION_CONTROL, profileStart);
 
 		if (lightDivider.process()) {
+			int64_t profileStart = profiler.begin();
 			lights[LIGHT_BIND + 0].setBrightness(learningId == -1 && mapLen > 0 ? 1.f : 0.f);
 			lights[LIGHT_BIND + 1].setBrightness(learningId >= 0 ? 1.f : 0.f);
+
+			NVGcolor indicatorColor = mappingIndicatorHidden ? color::BLACK_TRANSPARENT : nvgRGB(0xcd, 0x5c, 0x5c);
+			for (int id = 0; id < mapLen; id++) {
+				getParamHandle(id)->color = indicatorColor;
+			}
+			profiler.end(ProcessProfiler::SECTION_LIGHT, profileStart);
 		}
 	}
 
-	void commitLearn() override {
-		int i = learningId;
-		CVMapModuleBase<MAX_CHANNELS>::commitLearn();
+	/** Writes the pinned values back to the parameters of the due groups which deviate from them */
+	inline void processBlock(GripBlock* block, int len, uint32_t counter, uint32_t division) {
+		// Round up to full vectors, unmapped slots always match their pinned value
+		len = (len + 3) & ~3;
+		for (int i = 0; i < len; i += 4) {
+			if (((counter + i / 4) & (division - 1)) != 0) continue;
+			for (int j = i; j < i + 4; j++) {
+				if (!block->resolved[j] || block->modules[j] != block->paramHandles[j].module)
+					block->resolve(j);
+				block->currentValues[j] = *block->values[j];
+			}
+			simd::float_4 current = simd::float_4::load(&block->currentValues[i]);
+			simd::float_4 pinned = simd::float_4::load(&block->pinnedValues[i]);
+			int deviated = simd::movemask(current != pinned);
+			if (deviated == 0) continue;
+			for (int j = 0; j < 4; j++) {
+				if (!(deviated & (1 << j))) continue;
+				block->paramQuantities[i + j]->setValue(block->pinnedValues[i + j]);
+				// Keep the value the parameter settles at, the next pass sees no deviation then
+				block->pinnedValues[i + j] = *block->values[i + j];
+			}
+		}
+	}
+
+	inline ParamHandle* getParamHandle(int id) {
+		return &blocks[id / BLOCK_SIZE]->paramHandles[id % BLOCK_SIZE];
+	}
+
+	/** Allocates another block of slots, returns false if the pool is exhausted */
+	bool allocateBlock() {
+		if (blockLen >= MAX_BLOCKS)
+			return false;
+		blocks[blockLen] = new GripBlock;
+		blockLen++;
+		return true;
+	}
+
+	/** Returns the first unmapped slot, growing the pool if needed, or -1 if there is none */
+	int findEmptySlot() {
+		for (int id = 0; id < blockLen * BLOCK_SIZE; id++) {
+			if (getParamHandle(id)->moduleId < 0)
+				return id;
+		}
+		if (!allocateBlock())
+			return -1;
+		return (blockLen - 1) * BLOCK_SIZE;
+	}
 
-		if (i >= 0) {
-			ParamQuantity* paramQuantity = getParamQuantity(i);
-			if (paramQuantity) lastValue[i] = paramQuantity->getScaledValue();
+	/** Maps the handle of a slot, registers it with the engine on first use */
+	void bindParamHandle(int id, int moduleId, int paramId, bool overwrite) {
+		GripBlock* block = blocks[id / BLOCK_SIZE];
+		int i = id % BLOCK_SIZE;
+		if (moduleId < 0) {
+			unbindParamHandle(id);
+			return;
+		}
+		if (!block->paramHandleRegistered[i]) {
+			APP->engine->addParamHandle(&block->paramHandles[i]);
+			block->paramHandleRegistered[i] = true;
 		}
+		APP->engine->updateParamHandle(&block->paramHandles[i], moduleId, paramId, overwrite);
+		block->invalidate(i);
+		mappingRegistry.update(this, id, &block->paramHandles[i]);
+	}
+
+	/** Unmaps the handle of a slot and removes it from the engine */
+	void unbindParamHandle(int id) {
+		GripBlock* block = blocks[id / BLOCK_SIZE];
+		int i = id % BLOCK_SIZE;
+		block->invalidate(i);
+		if (!block->paramHandleRegistered[i])
+			return;
+		APP->engine->updateParamHandle(&block->paramHandles[i], -1, 0, true);
+		APP->engine->removeParamHandle(&block->paramHandles[i]);
+		block->paramHandleRegistered[i] = false;
+		mappingRegistry.remove(&block->paramHandles[i]);
+	}
+
+	void clearMap(int id) {
 		learningId = -1;
+		unbindParamHandle(id);
+		blocks[id / BLOCK_SIZE]->lastValue[id % BLOCK_SIZE] = -1;
+		updateMapLen();
 	}
 
-	void clearMap(int id) override {
-		CVMapModuleBase<MAX_CHANNELS>::clearMap(id);
-		lastValue[id] = -1;
+	void clearMaps() {
+		learningId = -1;
+		mapLen = 0;
+		for (int id = 0; id < blockLen * BLOCK_SIZE; id++) {
+			unbindParamHandle(id);
+			blocks[id / BLOCK_SIZE]->lastValue[id % BLOCK_SIZE] = -1;
+		}
+	}
+
+	void updateMapLen() {
+		// Find last nonempty map
+		int id;
+		for (id = blockLen * BLOCK_SIZE - 1; id >= 0; id--) {
+			if (getParamHandle(id)->moduleId >= 0)
+				break;
+		}
+		mapLen = id + 1;
+	}
+
+	void enableLearn(int id) {
+		learningId = id;
+	}
+
+	void disableLearn(int id) {
+		if (learningId == id) {
+			learningId = -1;
+		}
+	}
+
+	void learnParam(int id, int moduleId, int paramId) {
+		// Pin the current value of the parameter before the engine-thread can resolve the slot
+		Module* m = APP->engine->getModule(moduleId);
+		if (m) {
+			ParamQuantity* paramQuantity = m->paramQuantities[paramId];
+			if (paramQuantity) blocks[id / BLOCK_SIZE]->lastValue[id % BLOCK_SIZE] = paramQuantity->getScaledValue();
+		}
+		// The engine unbinds a slot which mapped the parameter before, release it as well
+		MappingEntry entry;
+		if (mappingRegistry.find(moduleId, paramId, &entry) && entry.owner == this && entry.slot != id) {
+			unbindParamHandle(entry.slot);
+			blocks[entry.slot / BLOCK_SIZE]->lastValue[entry.slot % BLOCK_SIZE] = -1;
+		}
+		bindParamHandle(id, moduleId, paramId, true);
+		learningId = -1;
+		updateMapLen();
 	}
 
 	json_t* dataToJson() override {
-		json_t* rootJ = CVMapModuleBase<MAX_CHANNELS>::dataToJson();
+		json_t* rootJ = json_object();
 		json_object_set_new(rootJ, "panelTheme", json_integer(panelTheme));
 		json_object_set_new(rootJ, "audioRate", json_boolean(audioRate));
+		json_object_set_new(rootJ, "mappingIndicatorHidden", json_boolean(mappingIndicatorHidden));
 
+		json_t* mapsJ = json_array();
 		json_t* lastValuesJ = json_array();
-		for (int i = 0; i < MAX_CHANNELS; i++) {
-			json_t* lastValueJ = json_real(lastValue[i]);
-			json_array_append(lastValuesJ, lastValueJ);
+		for (int id = 0; id < mapLen; id++) {
+			ParamHandle* paramHandle = getParamHandle(id);
+			json_t* mapJ = json_object();
+			json_object_set_new(mapJ, "moduleId", json_integer(paramHandle->moduleId));
+			json_object_set_new(mapJ, "paramId", json_integer(paramHandle->paramId));
+			json_array_append_new(mapsJ, mapJ);
+			json_array_append_new(lastValuesJ, json_real(blocks[id / BLOCK_SIZE]->lastValue[id % BLOCK_SIZE]));
 		}
+		json_object_set_new(rootJ, "maps", mapsJ);
 		json_object_set_new(rootJ, "lastValues", lastValuesJ);
 
  		return rootJ;
 	}
 
 	void dataFromJson(json_t* rootJ) override {
-		CVMapModuleBase<MAX_CHANNELS>::dataFromJson(rootJ);
+		clearMaps();
 		panelTheme = json_integer_value(json_object_get(rootJ, "panelTheme"));
 		audioRate = json_boolean_value(json_object_get(rootJ, "audioRate"));
+		mappingIndicatorHidden = json_boolean_value(json_object_get(rootJ, "mappingIndicatorHidden"));
 
+		json_t* mapsJ = json_object_get(rootJ, "maps");
 		json_t* lastValuesJ = json_object_get(rootJ, "lastValues");
-		for (int i = 0; i < MAX_CHANNELS; i++) {
-			json_t* lastValueJ = json_array_get(lastValuesJ, i);
-			lastValue[i] = json_real_value(lastValueJ);
+		if (mapsJ) {
+			json_t* mapJ;
+			size_t mapIndex;
+			json_array_foreach(mapsJ, mapIndex, mapJ) {
+				json_t* moduleIdJ = json_object_get(mapJ, "moduleId");
+				json_t* paramIdJ = json_object_get(mapJ, "paramId");
+				if (!(moduleIdJ && paramIdJ))
+					continue;
+				int id = mapIndex;
+				while (id >= blockLen * BLOCK_SIZE) {
+					if (!allocateBlock()) break;
+				}
+				if (id >= blockLen * BLOCK_SIZE)
+					continue;
+				json_t* lastValueJ = json_array_get(lastValuesJ, mapIndex);
+				if (lastValueJ) blocks[id / BLOCK_SIZE]->lastValue[id % BLOCK_SIZE] = json_real_value(lastValueJ);
+				bindParamHandle(id, json_integer_value(moduleIdJ), json_integer_value(paramIdJ), false);
+			}
 		}
+		updateMapLen();
 	}
 };
 
 
 struct MapButton : LEDBezel {
 	GripModule* module;
-	int id;
+	int id = -1;
 
 	void onSelect(const event::Select& e) override {
 		if (!module) return;
 
-		id = -1;
-		// Find last nonempty map
-		for (int i = 0; i < MAX_CHANNELS; i++) {
-			if (module->paramHandles[i].moduleId < 0) {
-				id = i;
-				break;
-			}
-		}
+		id = module->findEmptySlot();
 		// No more empty slots
 		if (id == -1) return;
 
@@ -137,6 +375,7 @@ struct MapButton : LEDBezel {
 
 	void onDeselect(const event::Deselect& e) override {
 		if (!module) return;
+		if (id < 0) return;
 		// Check if a ParamWidget was touched
 		ParamWidget* touchedParam = APP->scene->rack->touchedParam;
 		if (touchedParam && touchedParam->paramQuantity->module != module) {
@@ -199,7 +438,7 @@ struct GripWidget : ThemedModuleWidget<GripModule> {
 			}
 
 			std::string getParamName() {
-				ParamHandle* paramHandle = &module->paramHandles[id];
+				ParamHandle* paramHandle = module->getParamHandle(id);
 				if (paramHandle->moduleId < 0) return "<ERROR>";
 				ModuleWidget* mw = APP->scene->rack->getModule(paramHandle->moduleId);
 				if (!mw) return "<ERROR>";
@@ -217,13 +456,13 @@ struct GripWidget : ThemedModuleWidget<GripModule> {
 		};
 
 		menu->addChild(new MenuSeparator());
-		menu->addChild(construct<AudioRateItem>(&MenuItem::text, "Audio rate processing", &AudioRateItem::module, module));
+		menu->addChild(construct<AudioRateItem>(&MenuItem::text, "Hard pin (audio rate)", &AudioRateItem::module, module));
 
 		if (module->mapLen > 0) {
 			menu->addChild(new MenuSeparator());
 			menu->addChild(construct<MenuLabel>(&MenuLabel::text, "Locked parameters"));
-			for (int i = 0; i < MAX_CHANNELS; i++) {
-				if (module->paramHandles[i].moduleId >= 0) {
+			for (int i = 0; i < module->mapLen; i++) {
+				if (module->getParamHandle(i)->moduleId >= 0) {
 					menu->addChild(construct<UnmapItem>(&UnmapItem::module, module, &UnmapItem::id, i));
 				}
 			}
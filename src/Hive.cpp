@@ -151,7 +151,7 @@ struct HiveModule : Module {
 	dsp::Timer resetTimer[NUM_PORTS];
 	float resetTimer0;
 	dsp::PulseGenerator outPulse[NUM_PORTS];
-	ClockMultiplier multiplier[NUM_PORTS];
+	ClockMultiplier4 multiplier[(NUM_PORTS + 3) / 4];
 
 	dsp::SchmittTrigger shiftR1Trigger;			///
 	dsp::SchmittTrigger shiftR2Trigger;			///
@@ -210,33 +210,34 @@ struct HiveModule : Module {
 			for (int i = 0; i < NUM_PORTS; i++)
 				grid.moveCursor(i, (grid.cursor[i].dir + 8) % 12);				///
 
+		bool doPulse[NUM_PORTS];
 		for (int i = 0; i < NUM_PORTS; i++) {
 			active[i] = outputs[TRIG_OUTPUT + i].isConnected() || outputs[CV_OUTPUT + i].isConnected();
-			bool doPulse = false;
+			doPulse[i] = false;
 
 			if (processResetTrigger(i)) {
 				grid.cursor[i].pos = grid.cursor[i].startPos;					///
 				grid.cursor[i].dir = grid.cursor[i].startDir;					///
-				multiplier[i].reset();
+				multiplier[i / 4].reset(i % 4);
 			}
 
 			if (processClockTrigger(i, args.sampleTime)) {
 				grid.moveCursor(i, grid.cursor[i].dir);							///
-				multiplier[i].tick();
+				multiplier[i / 4].tick(i % 4);
 
 				switch (grid.getCell(grid.cursor[i].pos).state) {            	///
 					case GRIDSTATE::OFF:
 						break;
 					case GRIDSTATE::ON:
-						doPulse = true;
+						doPulse[i] = true;
 						break;
 					case GRIDSTATE::RANDOM:
 						if (grid.cursor[i].ratchetingEnabled) {
 							if (geoDist[i])
-								multiplier[i].trigger((*geoDist[i])(randGen));
+								multiplier[i / 4].trigger(i % 4, (*geoDist[i])(randGen));
 						}
 						else {
-							doPulse = random::uniform() >= 0.5f;
+							doPulse[i] = random::uniform() >= 0.5f;
 						}
 						break;
 				}
@@ -265,11 +266,19 @@ struct HiveModule : Module {
 						break;
 				}
 			}
+		}
+
+		// Advance the ratchets of all ports at once
+		int ratchets = 0;
+		for (int i = 0; i < NUM_PORTS; i += 4) {
+			ratchets |= multiplier[i / 4].process() << i;
+		}
 
+		for (int i = 0; i < NUM_PORTS; i++) {
 			float outGate = 0.f;
 			float outCv = outputs[CV_OUTPUT + i].getVoltage();
 
-			if (multiplier[i].process() || doPulse) {
+			if ((ratchets & (1 << i)) || doPulse[i]) {
 				outPulse[i].trigger();
 				HiveCell cell = grid.getCell(grid.cursor[i].pos);					///
 				switch (grid.cursor[i].outMode) {									///
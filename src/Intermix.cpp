@@ -112,17 +112,22 @@ struct IntermixModule : Module {
 
 	int sceneNext = -1;
 
-	LinearFade fader[PORTS][PORTS];
+	/** Fades of the cross-points, one bank for each input */
+	LinearFadeBank<PORTS> fader[PORTS];
 	//dsp::TSlewLimiter<simd::float_4> outputAtSlew[PORTS / 4];
 
 	dsp::SchmittTrigger sceneTrigger;
 	dsp::SchmittTrigger mapTrigger[PORTS];
 	dsp::ClockDivider sceneDivider;
 	dsp::ClockDivider lightDivider;
+	int profileRevision = -1;
+
+	ProcessProfiler profiler;
 
 	IntermixModule() {
 		panelTheme = pluginSettings.panelThemeDefault;
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+		profiler.attach(this);
 		for (int i = 0; i < SCENE_MAX; i++) {
 			configParam(PARAM_SCENE + i, 0.f, 1.f, 0.f, string::f("Scene %i", i + 1));
 		}
@@ -137,8 +142,7 @@ struct IntermixModule : Module {
 		}
 		configParam(PARAM_FADEIN, 0.f, 4.f, 0.f, "Fade in", "s");
 		configParam(PARAM_FADEOUT, 0.f, 4.f, 0.f, "Fade out", "s");
-		sceneDivider.setDivision(32);
-		lightDivider.setDivision(512);
+		applyProfile();
 		onReset();
 	}
 
@@ -165,7 +169,15 @@ struct IntermixModule : Module {
 		Module::onReset();
 	}
 
+	void applyProfile() {
+		profileRevision = pluginSettings.profileRevision;
+		sceneDivider.setDivision(pluginSettings.controlDivision(32));
+		lightDivider.setDivision(pluginSettings.lightDivision(512));
+	}
+
 	void process(const ProcessArgs& args) override {
+		if (profileRevision != pluginSettings.profileRevision)
+			applyProfile();
 		if (inputs[INPUT_SCENE].isConnected()) {
 			switch (sceneMode) {
 				case SCENE_CV_MODE::OFF: {
@@ -198,6 +210,7 @@ struct IntermixModule : Module {
 		}
 
 		if (sceneDivider.process()) {
+			int64_t profileStart = profiler.begin();
 			int sceneFound = -1;
 			for (int i = 0; i < SCENE_MAX; i++) {
 				if (params[PARAM_SCENE + i].getValue() > 0.f) {
@@ -232,17 +245,19 @@ struct IntermixModule : Module {
 			for (int i = 0; i < PORTS; i++) {
 				scenes[sceneSelected].output[i] = params[PARAM_OUTPUT + i].getValue() == 0.f ? OM_OUT : OM_OFF;
 				scenes[sceneSelected].outputAt[i] = params[PARAM_AT + i].getValue();
+				fader[i].setRiseFall(f1, f2);
 				for (int j = 0; j < PORTS; j++) {
-					fader[i][j].setRiseFall(f1, f2);
 					float p = params[PARAM_MATRIX + j * PORTS + i].getValue();
-					if (p != scenes[sceneSelected].matrix[i][j] && p == 1.f) fader[i][j].triggerFadeIn();
-					if (p != scenes[sceneSelected].matrix[i][j] && p == 0.f) fader[i][j].triggerFadeOut();
+					if (p != scenes[sceneSelected].matrix[i][j] && p == 1.f) fader[i].triggerFadeIn(j);
+					if (p != scenes[sceneSelected].matrix[i][j] && p == 0.f) fader[i].triggerFadeOut(j);
 					scenes[sceneSelected].matrix[i][j] = currentMatrix[i][j] = p;
 				}
 			}
+			profiler.end(ProcessProfiler::SECTION_CONTROL, profileStart);
 		}
 
 		// DSP processing
+		int64_t profileStart = profiler.begin();
 		simd::float_4 out[PORTS / 4] = {};
 		for (int i = 0; i < PORTS; i++) {
 			float v;
@@ -257,9 +272,7 @@ struct IntermixModule : Module {
 				case IN_MODE::IM_FADE:
 					if (!inputs[INPUT + i].isConnected()) continue;
 					v = inputs[INPUT + i].getVoltage();
-					for (int j = 0; j < PORTS; j++) {
-						currentMatrix[i][j] = fader[i][j].process(args.sampleTime);
-					}
+					fader[i].process(args.sampleTime, currentMatrix[i]);
 					break;
 				default:
 					v = (mode - 24) / 12.f;
@@ -303,9 +316,11 @@ struct IntermixModule : Module {
 			outputs[OUTPUT + i].setVoltage(out[i / 4][i % 4]);
 		}
 		// -- SIMD code --
+		profiler.end(ProcessProfiler::SECTION_AUDIO, profileStart);
 
 		// Lights
 		if (lightDivider.process()) {
+			int64_t profileStart = profiler.begin();
 			float s = lightDivider.getDivision() * args.sampleTime;
 
 			for (int i = 0; i < SCENE_MAX; i++) {
@@ -342,6 +357,7 @@ struct IntermixModule : Module {
 				float v = (scenes[sceneSelected].output[i] != OM_OUT) * padBrightness;
 				lights[LIGHT_OUTPUT + i].setSmoothBrightness(v, s);
 			}
+			profiler.end(ProcessProfiler::SECTION_LIGHT, profileStart);
 		}
 	}
 
@@ -375,8 +391,8 @@ struct IntermixModule : Module {
 			for (int j = 0; j < PORTS; j++) {
 				float p = scenes[sceneSelected].matrix[i][j];
 				params[PARAM_MATRIX + j * PORTS + i].setValue(p);
-				if (p != scenes[scenePrevious].matrix[i][j] && p == 1.f) fader[i][j].triggerFadeIn();
-				if (p != scenes[scenePrevious].matrix[i][j] && p == 0.f) fader[i][j].triggerFadeOut();
+				if (p != scenes[scenePrevious].matrix[i][j] && p == 1.f) fader[i].triggerFadeIn(j);
+				if (p != scenes[scenePrevious].matrix[i][j] && p == 0.f) fader[i].triggerFadeOut(j);
 				currentMatrix[i][j] = p;
 			}
 		}
@@ -410,7 +426,7 @@ struct IntermixModule : Module {
 				scenes[sceneSelected].matrix[i][j] = 0.f;
 				params[PARAM_MATRIX + j * PORTS + i].setValue(0.f);
 				currentMatrix[i][j] = 0.f;
-				fader[i][j].reset(0.f);
+				fader[i].reset(j, 0.f);
 			}
 		}
 	}
@@ -517,7 +533,7 @@ struct IntermixModule : Module {
 			for (int j = 0; j < PORTS; j++) {
 				float v = scenes[sceneSelected].matrix[i][j];
 				currentMatrix[i][j] = v;
-				fader[i][j].reset(v);
+				fader[i].reset(j, v);
 			}
 		}
 	}
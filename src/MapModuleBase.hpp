@@ -42,6 +42,96 @@ struct ParamHandleIndicator {
 };
 
 
+/** Resolved target of a mapping slot, avoids chasing the ParamHandle on every sample */
+struct ParamHandleCache {
+	/** Module the cache has been resolved against, compared with ParamHandle::module */
+	Module* module = NULL;
+	ParamQuantity* paramQuantity = NULL;
+	float minValue = 0.f;
+	float maxValue = 1.f;
+	bool resolved = false;
+
+	void resolve(ParamHandle* paramHandle) {
+		resolved = true;
+		module = paramHandle->module;
+		paramQuantity = NULL;
+		if (!module)
+			return;
+		ParamQuantity* pq = module->paramQuantities[paramHandle->paramId];
+		if (!pq)
+			return;
+		if (!pq->isBounded())
+			return;
+		paramQuantity = pq;
+		minValue = pq->getMinValue();
+		maxValue = pq->getMaxValue();
+	}
+
+	void invalidate() {
+		resolved = false;
+		module = NULL;
+		paramQuantity = NULL;
+	}
+};
+
+
+/** Name of a mapped parameter, avoids searching the module widgets on every frame */
+struct ParamNameCache {
+	bool valid = false;
+	int moduleId = -1;
+	int paramId = -1;
+	/** The engine rebinds ParamHandle::module when modules are added or removed */
+	Module* module = NULL;
+	std::string name;
+
+	/** Returns the name of the parameter mapped by the handle, empty if there is none */
+	const std::string& get(ParamHandle* paramHandle) {
+		if (!valid || paramHandle->moduleId != moduleId || paramHandle->paramId != paramId || paramHandle->module != module) {
+			valid = true;
+			moduleId = paramHandle->moduleId;
+			paramId = paramHandle->paramId;
+			module = paramHandle->module;
+			name = getParamName();
+		}
+		return name;
+	}
+
+	void invalidate() {
+		valid = false;
+	}
+
+	std::string getParamName() {
+		if (moduleId < 0)
+			return "";
+		ModuleWidget* mw = APP->scene->rack->getModule(moduleId);
+		if (!mw)
+			return "";
+		// Get the Module from the ModuleWidget instead of the ParamHandle.
+		// I think this is more elegant since this method is called in the app world instead of the engine world.
+		Module* m = mw->module;
+		if (!m)
+			return "";
+		if (paramId >= (int) m->params.size())
+			return "";
+		ParamQuantity* paramQuantity = m->paramQuantities[paramId];
+		std::string s;
+		s += mw->model->name;
+		s += " ";
+		s += paramQuantity->label;
+		return s;
+	}
+};
+
+
+enum SLOTRATE {
+	SLOTRATE_DEFAULT = 0,
+	SLOTRATE_AUDIO = 1,
+	SLOTRATE_DIV8 = 2,
+	SLOTRATE_DIV32 = 3,
+	SLOTRATE_DIV256 = 4
+};
+
+
 // Abstract modules
 
 template< int MAX_CHANNELS >
@@ -50,7 +140,18 @@ struct MapModuleBase : Module {
 	int mapLen = 0;
 	/** The mapped param handle of each channel */
 	ParamHandle paramHandles[MAX_CHANNELS];
+	/** Whether the param handle of each channel is registered with the engine */
+	bool paramHandleRegistered[MAX_CHANNELS];
 	ParamHandleIndicator paramHandleIndicator[MAX_CHANNELS];
+	/** The resolved target of each channel */
+	ParamHandleCache paramHandleCache[MAX_CHANNELS];
+	/** [Stored to JSON] The update rate of each channel */
+	SLOTRATE slotRate[MAX_CHANNELS];
+
+	/** Sample counter of the channel scheduler */
+	uint32_t slotCounter = 0;
+	/** Division used for channels on SLOTRATE_DEFAULT, must be a power of two */
+	uint32_t slotDefaultDivision = 1;
 
 	/** Channel ID of the learning session */
 	int learningId;
@@ -71,16 +172,21 @@ struct MapModuleBase : Module {
 
 	MapModuleBase() {
 		for (int id = 0; id < MAX_CHANNELS; id++) {
+			slotRate[id] = SLOTRATE_DEFAULT;
 			paramHandleIndicator[id].color = mappingIndicatorColor;
 			paramHandleIndicator[id].handle = &paramHandles[id];
-			APP->engine->addParamHandle(&paramHandles[id]);
+			// Param handles are registered with the engine only when a channel gets mapped
+			paramHandleRegistered[id] = false;
 		}
 		indicatorDivider.setDivision(2048);
+		mappingRegistry.registerOwner(this);
 	}
 
 	~MapModuleBase() {
+		mappingRegistry.unregisterOwner(this);
 		for (int id = 0; id < MAX_CHANNELS; id++) {
-			APP->engine->removeParamHandle(&paramHandles[id]);
+			if (paramHandleRegistered[id])
+				APP->engine->removeParamHandle(&paramHandles[id]);
 		}
 	}
 
@@ -103,24 +209,68 @@ struct MapModuleBase : Module {
 		}
 	}
 
-	ParamQuantity* getParamQuantity(int id) {
-		// Get Module
-		Module* module = paramHandles[id].module;
-		if (!module)
-			return NULL;
-		// Get ParamQuantity
-		int paramId = paramHandles[id].paramId;
-		ParamQuantity* paramQuantity = module->paramQuantities[paramId];
-		if (!paramQuantity)
-			return NULL;
-		if (!paramQuantity->isBounded())
-			return NULL;
-		return paramQuantity;
+	/** Advances the channel scheduler, must be called once per sample before slotDue() */
+	inline void stepSlotScheduler(uint32_t defaultDivision) {
+		slotCounter++;
+		slotDefaultDivision = defaultDivision;
+	}
+
+	/** Returns whether a channel should be updated on the current sample.
+	 * Blocks of four channels are offset by their index so updates of the same rate are spread
+	 * across samples while the channels of a block stay due together for float_4 processing.
+	 */
+	inline bool slotDue(int id) {
+		uint32_t division;
+		switch (slotRate[id]) {
+			default:
+			case SLOTRATE_DEFAULT: division = slotDefaultDivision; break;
+			case SLOTRATE_AUDIO: division = 1; break;
+			case SLOTRATE_DIV8: division = 8; break;
+			case SLOTRATE_DIV32: division = 32; break;
+			case SLOTRATE_DIV256: division = 256; break;
+		}
+		return ((slotCounter + (id >> 2)) & (division - 1)) == 0;
+	}
+
+	inline ParamQuantity* getParamQuantity(int id) {
+		ParamHandleCache* cache = &paramHandleCache[id];
+		// The engine rebinds or unbinds the handle when modules are added or removed
+		// or when another handle takes over the parameter, so the module is checked here.
+		if (!cache->resolved || cache->module != paramHandles[id].module)
+			cache->resolve(&paramHandles[id]);
+		return cache->paramQuantity;
+	}
+
+	/** Maps the handle of a channel, registers it with the engine on first use */
+	void bindParamHandle(int id, int moduleId, int paramId, bool overwrite) {
+		if (moduleId < 0) {
+			unbindParamHandle(id);
+			return;
+		}
+		if (!paramHandleRegistered[id]) {
+			APP->engine->addParamHandle(&paramHandles[id]);
+			paramHandleRegistered[id] = true;
+		}
+		APP->engine->updateParamHandle(&paramHandles[id], moduleId, paramId, overwrite);
+		paramHandleCache[id].invalidate();
+		mappingRegistry.update(this, id, &paramHandles[id]);
+	}
+
+	/** Unmaps the handle of a channel and removes it from the engine */
+	void unbindParamHandle(int id) {
+		paramHandleCache[id].invalidate();
+		if (!paramHandleRegistered[id])
+			return;
+		APP->engine->updateParamHandle(&paramHandles[id], -1, 0, true);
+		APP->engine->removeParamHandle(&paramHandles[id]);
+		paramHandleRegistered[id] = false;
+		mappingRegistry.remove(&paramHandles[id]);
 	}
 
 	virtual void clearMap(int id) {
 		learningId = -1;
-		APP->engine->updateParamHandle(&paramHandles[id], -1, 0, true);
+		unbindParamHandle(id);
+		slotRate[id] = SLOTRATE_DEFAULT;
 		valueFilters[id].reset();
 		updateMapLen();
 	}
@@ -128,7 +278,8 @@ struct MapModuleBase : Module {
 	virtual void clearMaps() {
 		learningId = -1;
 		for (int id = 0; id < MAX_CHANNELS; id++) {
-			APP->engine->updateParamHandle(&paramHandles[id], -1, 0, true);
+			unbindParamHandle(id);
+			slotRate[id] = SLOTRATE_DEFAULT;
 			valueFilters[id].reset();
 		}
 		mapLen = 0;
@@ -176,7 +327,14 @@ struct MapModuleBase : Module {
 	}
 
 	virtual void learnParam(int id, int moduleId, int paramId) {
-		APP->engine->updateParamHandle(&paramHandles[id], moduleId, paramId, true);
+		// The engine unbinds a channel which mapped the parameter before, release it as well
+		MappingEntry entry;
+		if (mappingRegistry.find(moduleId, paramId, &entry) && entry.owner == this && entry.slot != id) {
+			unbindParamHandle(entry.slot);
+			slotRate[entry.slot] = SLOTRATE_DEFAULT;
+			valueFilters[entry.slot].reset();
+		}
+		bindParamHandle(id, moduleId, paramId, true);
 		learnedParam = true;
 		commitLearn();
 		updateMapLen();
@@ -193,6 +351,7 @@ struct MapModuleBase : Module {
 			json_t* mapJ = json_object();
 			json_object_set_new(mapJ, "moduleId", json_integer(paramHandles[id].moduleId));
 			json_object_set_new(mapJ, "paramId", json_integer(paramHandles[id].paramId));
+			json_object_set_new(mapJ, "slotRate", json_integer(slotRate[id]));
 			json_array_append_new(mapsJ, mapJ);
 		}
 		json_object_set_new(rootJ, "maps", mapsJ);
@@ -219,7 +378,9 @@ struct MapModuleBase : Module {
 					continue;
 				if (mapIndex >= MAX_CHANNELS)
 					continue;
-				APP->engine->updateParamHandle(&paramHandles[mapIndex], json_integer_value(moduleIdJ), json_integer_value(paramIdJ), false);
+				bindParamHandle(mapIndex, json_integer_value(moduleIdJ), json_integer_value(paramIdJ), false);
+				json_t* slotRateJ = json_object_get(mapJ, "slotRate");
+				if (slotRateJ) slotRate[mapIndex] = (SLOTRATE)json_integer_value(slotRateJ);
 			}
 		}
 		updateMapLen();
@@ -275,6 +436,12 @@ struct MapModuleChoice : LedDisplayChoice {
 	std::chrono::time_point<std::chrono::system_clock> hscrollUpdate = std::chrono::system_clock::now();
 	int hscrollCharOffset = 0;
 
+	ParamNameCache paramNameCache;
+	/** Parts the current text has been built from */
+	std::string textPrefix;
+	std::string textLabel;
+	int textCharOffset = -1;
+
 	MapModuleChoice() {
 		box.size = mm2px(Vec(0, 7.5));
 		textOffset = Vec(6, 14.7);
@@ -355,6 +522,7 @@ struct MapModuleChoice : LedDisplayChoice {
 			int moduleId = touchedParam->paramQuantity->module->id;
 			int paramId = touchedParam->paramQuantity->paramId;
 			module->learnParam(id, moduleId, paramId);
+			paramNameCache.invalidate();
 			hscrollCharOffset = 0;
 		} 
 		else {
@@ -382,35 +550,36 @@ struct MapModuleChoice : LedDisplayChoice {
 		// Set text
 		if (module->paramHandles[id].moduleId >= 0 && module->learningId != id) {
 			std::string prefix = "";
-			std::string label = getSlotLabel();
-			if (label == "") {
+			std::string slotLabel = getSlotLabel();
+			const std::string* label = &slotLabel;
+			if (slotLabel == "") {
 				prefix = getSlotPrefix();
-				label = getParamName();
-				if (label == "") {
+				label = &paramNameCache.get(&module->paramHandles[id]);
+				if (*label == "") {
 					module->clearMap(id);
 					return;
 				}
 			}
 
 			size_t hscrollMaxLength = ceil(box.size.x / 6.2f);
-			if (module->textScrolling && label.length() + prefix.length() > hscrollMaxLength) {
+			if (module->textScrolling && label->length() + prefix.length() > hscrollMaxLength) {
 				// Scroll the parameter-name horizontically
-				text = prefix + label.substr(hscrollCharOffset > (int)label.length() ? 0 : hscrollCharOffset);
+				setText(prefix, *label, hscrollCharOffset > (int)label->length() ? 0 : hscrollCharOffset);
 				auto now = std::chrono::system_clock::now();
 				if (now - hscrollUpdate > std::chrono::milliseconds{100}) {
-					hscrollCharOffset = (hscrollCharOffset + 1) % (label.length() + hscrollMaxLength);
+					hscrollCharOffset = (hscrollCharOffset + 1) % (label->length() + hscrollMaxLength);
 					hscrollUpdate = now;
 				}
 			} 
 			else {
-				text = prefix + label;
+				setText(prefix, *label, 0);
 			}
 		} 
 		else {
 			if (module->learningId == id) {
-				text = getSlotPrefix() + "Mapping...";
+				setText(getSlotPrefix(), "Mapping...", 0);
 			} else {
-				text = getSlotPrefix() + "Unmapped";
+				setText(getSlotPrefix(), "Unmapped", 0);
 			}
 		}
 
@@ -423,6 +592,17 @@ struct MapModuleChoice : LedDisplayChoice {
 		}
 	}
 
+	/** Rebuilds the text only if one of its parts has changed */
+	void setText(const std::string& prefix, const std::string& label, int charOffset) {
+		if (charOffset == textCharOffset && prefix == textPrefix && label == textLabel)
+			return;
+		textPrefix = prefix;
+		textLabel = label;
+		textCharOffset = charOffset;
+		text = prefix;
+		text.append(label, charOffset, std::string::npos);
+	}
+
 	virtual std::string getSlotLabel() {
 		return "";
 	}
@@ -436,26 +616,50 @@ struct MapModuleChoice : LedDisplayChoice {
 			return "";
 		if (id >= module->mapLen)
 			return "";
-		ParamHandle* paramHandle = &module->paramHandles[id];
-		if (paramHandle->moduleId < 0)
-			return "";
-		ModuleWidget *mw = APP->scene->rack->getModule(paramHandle->moduleId);
-		if (!mw)
-			return "";
-		// Get the Module from the ModuleWidget instead of the ParamHandle.
-		// I think this is more elegant since this method is called in the app world instead of the engine world.
-		Module* m = mw->module;
-		if (!m)
-			return "";
-		int paramId = paramHandle->paramId;
-		if (paramId >= (int) m->params.size())
-			return "";
-		ParamQuantity* paramQuantity = m->paramQuantities[paramId];
-		std::string s;
-		s += mw->model->name;
-		s += " ";
-		s += paramQuantity->label;
-		return s;
+		return paramNameCache.get(&module->paramHandles[id]);
+	}
+};
+
+template< typename MODULE >
+struct SlotRateMenuItem : MenuItem {
+	MODULE* module;
+	int id;
+
+	SlotRateMenuItem() {
+		rightText = RIGHT_ARROW;
+	}
+
+	struct SlotRateItem : MenuItem {
+		MODULE* module;
+		int id;
+		SLOTRATE slotRate;
+
+		void onAction(const event::Action& e) override {
+			module->slotRate[id] = slotRate;
+		}
+
+		void step() override {
+			rightText = module->slotRate[id] == slotRate ? "✔" : "";
+			MenuItem::step();
+		}
+	};
+
+	Menu* createChildMenu() override {
+		Menu* menu = new Menu;
+		menu->addChild(construct<SlotRateItem>(&MenuItem::text, "Module default", &SlotRateItem::module, module, &SlotRateItem::id, id, &SlotRateItem::slotRate, SLOTRATE_DEFAULT));
+		menu->addChild(construct<SlotRateItem>(&MenuItem::text, "Audio rate", &SlotRateItem::module, module, &SlotRateItem::id, id, &SlotRateItem::slotRate, SLOTRATE_AUDIO));
+		menu->addChild(construct<SlotRateItem>(&MenuItem::text, "Every 8th sample", &SlotRateItem::module, module, &SlotRateItem::id, id, &SlotRateItem::slotRate, SLOTRATE_DIV8));
+		menu->addChild(construct<SlotRateItem>(&MenuItem::text, "Every 32nd sample", &SlotRateItem::module, module, &SlotRateItem::id, id, &SlotRateItem::slotRate, SLOTRATE_DIV32));
+		menu->addChild(construct<SlotRateItem>(&MenuItem::text, "Every 256th sample", &SlotRateItem::module, module, &SlotRateItem::id, id, &SlotRateItem::slotRate, SLOTRATE_DIV256));
+		return menu;
+	}
+};
+
+template< int MAX_CHANNELS, typename MODULE >
+struct MapModuleSlotRateChoice : MapModuleChoice<MAX_CHANNELS, MODULE> {
+	void appendContextMenu(Menu* menu) override {
+		menu->addChild(new MenuSeparator());
+		menu->addChild(construct<SlotRateMenuItem<MODULE>>(&MenuItem::text, "Update rate", &SlotRateMenuItem<MODULE>::module, this->module, &SlotRateMenuItem<MODULE>::id, this->id));
 	}
 };
 
@@ -106,7 +106,7 @@ struct MazeModule : Module {
 	dsp::Timer resetTimer[NUM_PORTS];
 	float resetTimer0;
 	dsp::PulseGenerator outPulse[NUM_PORTS];
-	ClockMultiplier multiplier[NUM_PORTS];
+	ClockMultiplier4 multiplier[(NUM_PORTS + 3) / 4];
 
 	dsp::SchmittTrigger shiftRTrigger;
 	dsp::SchmittTrigger shiftLTrigger;
@@ -163,36 +163,37 @@ struct MazeModule : Module {
 			}
 		}
 
+		bool doPulse[NUM_PORTS];
 		for (int i = 0; i < NUM_PORTS; i++) {
 			active[i] = outputs[TRIG_OUTPUT + i].isConnected() || outputs[CV_OUTPUT + i].isConnected();
-			bool doPulse = false;
+			doPulse[i] = false;
 
 			if (processResetTrigger(i)) {
 				xPos[i] = xStartPos[i];
 				yPos[i] = yStartPos[i];
 				xDir[i] = xStartDir[i];
 				yDir[i] = yStartDir[i];
-				multiplier[i].reset();
+				multiplier[i / 4].reset(i % 4);
 			}
 
 			if (processClockTrigger(i, args.sampleTime)) {
 				xPos[i] = (xPos[i] + xDir[i] + usedSize) % usedSize;
 				yPos[i] = (yPos[i] + yDir[i] + usedSize) % usedSize;
-				multiplier[i].tick();
+				multiplier[i / 4].tick(i % 4);
 
 				switch (grid[xPos[i]][yPos[i]]) {
 					case GRIDSTATE::OFF:
 						break;
 					case GRIDSTATE::ON:
-						doPulse = true;
+						doPulse[i] = true;
 						break;
 					case GRIDSTATE::RANDOM:
 						if (ratchetingEnabled[i]) {
 							if (geoDist[i])
-								multiplier[i].trigger((*geoDist[i])(randGen));
+								multiplier[i / 4].trigger(i % 4, (*geoDist[i])(randGen));
 						}
 						else {
-							doPulse = random::uniform() >= 0.5f;
+							doPulse[i] = random::uniform() >= 0.5f;
 						}
 						break;
 				}
@@ -216,11 +217,19 @@ struct MazeModule : Module {
 					yDir[i] = turnMode[i] == TURNMODE::NINETY ? 0 : 1;
 				}
 			}
+		}
+
+		// Advance the ratchets of all ports at once
+		int ratchets = 0;
+		for (int i = 0; i < NUM_PORTS; i += 4) {
+			ratchets |= multiplier[i / 4].process() << i;
+		}
 
+		for (int i = 0; i < NUM_PORTS; i++) {
 			float outGate = 0.f;
 			float outCv = outputs[CV_OUTPUT + i].getVoltage();
 
-			if (multiplier[i].process() || doPulse) {
+			if ((ratchets & (1 << i)) || doPulse[i]) {
 				outPulse[i].trigger();
 				switch (outMode[i]) {
 					case OUTMODE::BI_5V:
@@ -1,6 +1,7 @@
 #include "plugin.hpp"
 #include "MapModuleBase.hpp"
 #include <osdialog.h>
+#include <atomic>
 
 
 namespace MidiCat {
@@ -8,51 +9,161 @@ namespace MidiCat {
 static const int MAX_CHANNELS = 128;
 static const char PRESET_FILTERS[] = "VCV Rack module preset (.vcvm):vcvm";
 
+/** Queued feedback older than this is sent before recently touched controls, in seconds */
+static const float FEEDBACK_MAX_AGE = 0.05f;
+static const int FEEDBACK_GATE_QUEUE_SIZE = 256;
+
 struct MidiCatOutput : midi::Output {
 	int lastValues[128];
 	bool lastGates[128];
 
+	/** Queued value of each CC number, -1 if none */
+	int pendingValues[128];
+	/** Queued CCs as a list from least to most recently touched, -1 terminates */
+	int pendingPrev[128];
+	int pendingNext[128];
+	int pendingFront = -1;
+	int pendingBack = -1;
+	/** Frame at which each queued CC has been queued */
+	uint32_t pendingFrames[128];
+	uint32_t frame = 0;
+
+	/** Queued note edges, sent in order and never coalesced so a short note is not lost */
+	struct GateEdge {
+		uint8_t note;
+		uint8_t vel;
+	};
+	GateEdge gateQueue[FEEDBACK_GATE_QUEUE_SIZE];
+	int gateHead = 0;
+	int gateCount = 0;
+
+	/** [Stored to JSON] Maximum number of messages per second, 0 for unlimited */
+	int rateLimit = 1000;
+	/** Number of messages which can be sent right now */
+	float budget = 0.f;
+
+	/** Number of updates merged into an already queued message */
+	uint32_t coalescedCount = 0;
+	/** Number of queued messages discarded without being sent */
+	uint32_t droppedCount = 0;
+
 	MidiCatOutput() {
 		reset();
 	}
 
 	void reset() {
+		while (pendingFront >= 0) {
+			unlinkPending(pendingFront);
+			droppedCount++;
+		}
+		droppedCount += gateCount;
+		gateCount = 0;
 		for (int n = 0; n < 128; n++) {
 			lastValues[n] = -1;
 			lastGates[n] = false;
+			pendingValues[n] = -1;
 		}
 	}
 
+	/** Changes the rate limit, the budget of the previous rate does not carry over */
+	void setRateLimit(int rateLimit) {
+		this->rateLimit = std::max(rateLimit, 0);
+		budget = 0.f;
+	}
+
 	void setValue(int value, int cc) {
 		if (value == lastValues[cc])
 			return;
 		lastValues[cc] = value;
-		// CC
+		// Last value wins if the CC is still queued, it moves to the back as most recently touched
+		if (pendingValues[cc] >= 0) {
+			coalescedCount++;
+			unlinkPending(cc);
+		}
+		else {
+			pendingFrames[cc] = frame;
+		}
+		pendingValues[cc] = value;
+		linkPending(cc);
+	}
+
+	void setGate(int vel, int note) {
+		bool gate = vel > 0;
+		if (gate == lastGates[note])
+			return;
+		lastGates[note] = gate;
+		if (gateCount == FEEDBACK_GATE_QUEUE_SIZE) {
+			droppedCount++;
+			return;
+		}
+		GateEdge& e = gateQueue[(gateHead + gateCount) % FEEDBACK_GATE_QUEUE_SIZE];
+		e.note = note;
+		e.vel = vel;
+		gateCount++;
+	}
+
+	void process(float sampleTime) {
+		frame++;
+		if (rateLimit > 0) {
+			// Allow bursts of at most 1ms worth of messages
+			budget = std::min(budget + rateLimit * sampleTime, std::max(1.f, rateLimit / 1000.f));
+		}
+		while ((gateCount > 0 || pendingFront >= 0) && (rateLimit == 0 || budget >= 1.f)) {
+			if (gateCount > 0) {
+				sendGate();
+			}
+			// Send the most recently touched control first unless the least recent one waits too long
+			else if ((frame - pendingFrames[pendingFront]) * sampleTime >= FEEDBACK_MAX_AGE) {
+				sendPending(pendingFront);
+			}
+			else {
+				sendPending(pendingBack);
+			}
+			if (rateLimit > 0) budget -= 1.f;
+		}
+	}
+
+	void linkPending(int cc) {
+		pendingPrev[cc] = pendingBack;
+		pendingNext[cc] = -1;
+		if (pendingBack >= 0)
+			pendingNext[pendingBack] = cc;
+		else
+			pendingFront = cc;
+		pendingBack = cc;
+	}
+
+	void unlinkPending(int cc) {
+		if (pendingPrev[cc] >= 0)
+			pendingNext[pendingPrev[cc]] = pendingNext[cc];
+		else
+			pendingFront = pendingNext[cc];
+		if (pendingNext[cc] >= 0)
+			pendingPrev[pendingNext[cc]] = pendingPrev[cc];
+		else
+			pendingBack = pendingPrev[cc];
+		pendingValues[cc] = -1;
+	}
+
+	void sendPending(int cc) {
 		midi::Message m;
 		m.setStatus(0xb);
 		m.setNote(cc);
-		m.setValue(value);
+		m.setValue(pendingValues[cc]);
+		unlinkPending(cc);
 		sendMessage(m);
 	}
 
-	void setGate(int vel, int note) {
-		if (vel > 0 && !lastGates[note]) {
-			// Note on
-			midi::Message m;
-			m.setStatus(0x9);
-			m.setNote(note);
-			m.setValue(vel);
-			sendMessage(m);
-		}
-		else if (vel == 0 && lastGates[note]) {
-			// Note off
-			midi::Message m;
-			m.setStatus(0x8);
-			m.setNote(note);
-			m.setValue(0);
-			sendMessage(m);
-		}
-		lastGates[note] = vel > 0;
+	void sendGate() {
+		GateEdge& e = gateQueue[gateHead];
+		midi::Message m;
+		// Note on or note off
+		m.setStatus(e.vel > 0 ? 0x9 : 0x8);
+		m.setNote(e.note);
+		m.setValue(e.vel);
+		gateHead = (gateHead + 1) % FEEDBACK_GATE_QUEUE_SIZE;
+		gateCount--;
+		sendMessage(m);
 	}
 };
 
@@ -109,6 +220,8 @@ struct MidiCatModule : Module {
 
 	/** The mapped param handle of each channel */
 	ParamHandle paramHandles[MAX_CHANNELS];
+	/** Whether the param handle of each channel is registered with the engine */
+	bool paramHandleRegistered[MAX_CHANNELS];
 	ParamHandleIndicator paramHandleIndicator[MAX_CHANNELS];
 
 	/** Channel ID of the learning session */
@@ -143,29 +256,52 @@ struct MidiCatModule : Module {
 	int lastValueInIndicate[MAX_CHANNELS];
 	float lastValueOut[MAX_CHANNELS];
 
+	/** Reverse index: first channel bound to each CC number, -1 if none */
+	int ccFirstId[128];
+	/** Reverse index: first channel bound to each note number, -1 if none */
+	int noteFirstId[128];
+	/** Next channel bound to the same CC number, always a higher id or -1 */
+	int ccNextId[MAX_CHANNELS];
+	/** Next channel bound to the same note number, always a higher id or -1 */
+	int noteNextId[MAX_CHANNELS];
+	/** Set when ccs or notes have changed, the reverse index is rebuilt on the engine-thread */
+	std::atomic<bool> indexDirty{true};
+	/** Channels to be stepped on the next sample */
+	int dirtyIds[MAX_CHANNELS];
+	int dirtyLen = 0;
+	bool dirty[MAX_CHANNELS];
+
 	//dsp::ExponentialFilter valueFilters[MAX_CHANNELS];
 	//bool filterInitialized[MAX_CHANNELS] = {};
 
 	dsp::ClockDivider loopDivider;
 	dsp::ClockDivider indicatorDivider;
+	int profileRevision = -1;
+
+	ProcessProfiler profiler;
 
 	MidiCatModule() {
 		panelTheme = pluginSettings.panelThemeDefault;
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+		profiler.attach(this);
 		for (int id = 0; id < MAX_CHANNELS; id++) {
 			paramHandleIndicator[id].color = mappingIndicatorColor;
 			paramHandleIndicator[id].handle = &paramHandles[id];
 			//valueFilters[id].lambda = 1 / 0.01f;
-			APP->engine->addParamHandle(&paramHandles[id]);
+			// Param handles are registered with the engine only when a channel gets mapped
+			paramHandleRegistered[id] = false;
+			dirty[id] = false;
 		}
-		loopDivider.setDivision(128);
-		indicatorDivider.setDivision(2048);
+		applyProfile();
+		mappingRegistry.registerOwner(this);
 		onReset();
 	}
 
 	~MidiCatModule() {
+		mappingRegistry.unregisterOwner(this);
 		for (int id = 0; id < MAX_CHANNELS; id++) {
-			APP->engine->removeParamHandle(&paramHandles[id]);
+			if (paramHandleRegistered[id])
+				APP->engine->removeParamHandle(&paramHandles[id]);
 		}
 	}
 
@@ -195,172 +331,202 @@ struct MidiCatModule : Module {
 		midiOutput.midi::Output::reset();
 	}
 
+	void applyProfile() {
+		profileRevision = pluginSettings.profileRevision;
+		loopDivider.setDivision(pluginSettings.controlDivision(128));
+		indicatorDivider.setDivision(pluginSettings.lightDivision(2048));
+	}
+
 	void process(const ProcessArgs &args) override {
+		if (profileRevision != pluginSettings.profileRevision)
+			applyProfile();
+		int64_t profileStart = profiler.begin();
+		if (indexDirty.exchange(false))
+			rebuildIndex();
 		midi::Message msg;
-		bool changed = false;
 		while (midiInput.shift(&msg)) {
-			bool r = processMessage(msg);
-			changed = changed || r;
+			processMessage(msg);
 		}
 
-		// Only step channels when some midi event has been received. Additionally
-		// step channels for parameter changes made manually every 128th loop. Notice
+		// Step all channels for parameter changes made manually every 128th loop. Notice
 		// that midi allows about 1000 messages per second, so checking for changes more often
 		// won't lead to higher precision on midi output.
-		if (changed || loopDivider.process()) {
-			// Step channels
+		if (loopDivider.process()) {
 			for (int id = 0; id < mapLen; id++) {
-				int cc = ccs[id];
-				int note = notes[id];
-				if (cc < 0 && note < 0)
-					continue;
+				processChannel(id);
+			}
+		}
+		// Otherwise only step channels bound to a CC or note which has changed. Feedback of
+		// a channel marks the other channels of its CC, these are stepped here too.
+		if (dirtyLen > 0) {
+			for (int i = 0; i < dirtyLen; i++) {
+				processChannel(dirtyIds[i]);
+			}
+			clearDirty();
+		}
 
-				// Get Module
-				Module *module = paramHandles[id].module;
-				if (!module)
-					continue;
+		midiOutput.process(args.sampleTime);
+		profiler.end(ProcessProfiler::SECTION_CONTROL, profileStart);
 
-				// Get ParamQuantity
-				int paramId = paramHandles[id].paramId;
-				ParamQuantity *paramQuantity = module->paramQuantities[paramId];
-				if (!paramQuantity)
-					continue;
+		if (indicatorDivider.process()) {
+			int64_t profileStart = profiler.begin();
+			float t = indicatorDivider.getDivision() * args.sampleTime;
+			for (int i = 0; i < mapLen; i++) {
+				paramHandleIndicator[i].color = mappingIndicatorHidden ? color::BLACK_TRANSPARENT : mappingIndicatorColor;
+				if (paramHandles[i].moduleId >= 0) {
+					paramHandleIndicator[i].process(t);
+				}
+			}
+			profiler.end(ProcessProfiler::SECTION_LIGHT, profileStart);
+		}
+	}
 
-				if (!paramQuantity->isBounded())
-					continue;
+	void processChannel(int id) {
+		int cc = ccs[id];
+		int note = notes[id];
+		if (cc < 0 && note < 0)
+			return;
 
-				switch (midiMode) {
-					case MIDIMODE::MIDIMODE_DEFAULT: {
-						// Set filter from param value if filter is uninitialized
-						//if (!filterInitialized[id]) {
-						//	valueFilters[id].out = paramQuantity->getScaledValue();
-						//	filterInitialized[id] = true;
-						//}
-
-						// Check if CC value has been set
-						if (cc >= 0 && valuesCc[cc] >= 0)
-						{
-							int t = -1;
-							switch (ccsMode[id]) {
-								case CCMODE_DIRECT:
-									if (lastValueIn[id] != valuesCc[cc]) {
-										lastValueIn[id] = valuesCc[cc];
-										t = valuesCc[cc];
-									}
-									break;
-								case CCMODE_PICKUP1:
-									if (lastValueIn[id] != valuesCc[cc]) {
-										int p = (int)rescale(paramQuantity->getValue(), paramQuantity->getMinValue(), paramQuantity->getMaxValue(), 0.f, 127.f);
-										if (p - 3 <= lastValueIn[id] && lastValueIn[id] <= p + 3) {
-											t = valuesCc[cc];
-										}
-										lastValueIn[id] = valuesCc[cc];
-									}
-									break;
-								case CCMODE_PICKUP2:
-									if (lastValueIn[id] != valuesCc[cc]) {
-										int p = (int)rescale(paramQuantity->getValue(), paramQuantity->getMinValue(), paramQuantity->getMaxValue(), 0.f, 127.f);
-										if (p - 3 <= lastValueIn[id] && lastValueIn[id] <= p + 3 && p - 7 <= valuesCc[cc] && valuesCc[cc] <= p + 7) {
-											t = valuesCc[cc];
-										}
-										lastValueIn[id] = valuesCc[cc];
-									}
-									break;
-							}
+		// Get Module
+		Module *module = paramHandles[id].module;
+		if (!module)
+			return;
 
-							if (t >= 0) {
-								float v = rescale(t, 0.f, 127.f, paramQuantity->getMinValue(), paramQuantity->getMaxValue());
-								//v = valueFilters[id].process(args.sampleTime * loopDivider.getDivision(), v);
-								paramQuantity->setValue(v);
-							}
-						}
+		// Get ParamQuantity
+		int paramId = paramHandles[id].paramId;
+		ParamQuantity *paramQuantity = module->paramQuantities[paramId];
+		if (!paramQuantity)
+			return;
 
-						// Check if note value has been set
-						if (note >= 0 && valuesNote[note] >= 0)
-						{
-							int t = -1;
-							switch (notesMode[id]) {
-								case NOTEMODE::NOTEMODE_MOMENTARY:
-									if (lastValueIn[id] != valuesNote[note]) {
-										t = valuesNote[note];
-										if (t > 0) t = 127;
-										lastValueIn[id] = valuesNote[note];
-									} 
-									break;
-								case NOTEMODE::NOTEMODE_MOMENTARY_VEL:
-									if (lastValueIn[id] != valuesNote[note]) {
-										t = valuesNote[note];
-										lastValueIn[id] = valuesNote[note];
-									}
-									break;
-								case NOTEMODE::NOTEMODE_TOGGLE:
-									if (valuesNote[note] > 0 && (lastValueIn[id] == -1 || lastValueIn[id] >= 0)) {
-										t = 127;
-										lastValueIn[id] = -2;
-									} 
-									else if (valuesNote[note] == 0 && lastValueIn[id] == -2) {
-										t = 127;
-										lastValueIn[id] = -3;
-									}
-									else if (valuesNote[note] > 0 && lastValueIn[id] == -3) {
-										t = 0;
-										lastValueIn[id] = -4;
-									}
-									else if (valuesNote[note] == 0 && lastValueIn[id] == -4) {
-										t = 0;
-										lastValueIn[id] = -1;
-									}
-									break;
-							}
+		if (!paramQuantity->isBounded())
+			return;
 
-							if (t >= 0) {
-								float v = rescale(t, 0.f, 127.f, paramQuantity->getMinValue(), paramQuantity->getMaxValue());
-								// Do not use filters on notes
-								paramQuantity->setValue(v);
+		switch (midiMode) {
+			case MIDIMODE::MIDIMODE_DEFAULT: {
+				// Set filter from param value if filter is uninitialized
+				//if (!filterInitialized[id]) {
+				//	valueFilters[id].out = paramQuantity->getScaledValue();
+				//	filterInitialized[id] = true;
+				//}
+
+				// Check if CC value has been set
+				if (cc >= 0 && valuesCc[cc] >= 0)
+				{
+					int t = -1;
+					switch (ccsMode[id]) {
+						case CCMODE_DIRECT:
+							if (lastValueIn[id] != valuesCc[cc]) {
+								lastValueIn[id] = valuesCc[cc];
+								t = valuesCc[cc];
 							}
-						}
+							break;
+						case CCMODE_PICKUP1:
+							if (lastValueIn[id] != valuesCc[cc]) {
+								int p = (int)rescale(paramQuantity->getValue(), paramQuantity->getMinValue(), paramQuantity->getMaxValue(), 0.f, 127.f);
+								if (p - 3 <= lastValueIn[id] && lastValueIn[id] <= p + 3) {
+									t = valuesCc[cc];
+								}
+								lastValueIn[id] = valuesCc[cc];
+							}
+							break;
+						case CCMODE_PICKUP2:
+							if (lastValueIn[id] != valuesCc[cc]) {
+								int p = (int)rescale(paramQuantity->getValue(), paramQuantity->getMinValue(), paramQuantity->getMaxValue(), 0.f, 127.f);
+								if (p - 3 <= lastValueIn[id] && lastValueIn[id] <= p + 3 && p - 7 <= valuesCc[cc] && valuesCc[cc] <= p + 7) {
+									t = valuesCc[cc];
+								}
+								lastValueIn[id] = valuesCc[cc];
+							}
+							break;
+					}
+
+					if (t >= 0) {
+						float v = rescale(t, 0.f, 127.f, paramQuantity->getMinValue(), paramQuantity->getMaxValue());
+						//v = valueFilters[id].process(args.sampleTime * loopDivider.getDivision(), v);
+						paramQuantity->setValue(v);
+					}
+				}
 
-						// Midi feedback
-						float v = paramQuantity->getValue();
-						if (lastValueOut[id] != v) {
-							lastValueOut[id] = v;
-							v = rescale(v, paramQuantity->getMinValue(), paramQuantity->getMaxValue(), 0.f, 127.f);
-							if (cc >= 0 && ccsMode[id] == CCMODE_DIRECT)
-								lastValueIn[id] = valuesCc[cc] = v;
-							if (cc >= 0)
-								midiOutput.setValue(v, cc);
-							if (note >= 0)
-								midiOutput.setGate(v, note);
-						}
-					} break;
+				// Check if note value has been set
+				if (note >= 0 && valuesNote[note] >= 0)
+				{
+					int t = -1;
+					switch (notesMode[id]) {
+						case NOTEMODE::NOTEMODE_MOMENTARY:
+							if (lastValueIn[id] != valuesNote[note]) {
+								t = valuesNote[note];
+								if (t > 0) t = 127;
+								lastValueIn[id] = valuesNote[note];
+							} 
+							break;
+						case NOTEMODE::NOTEMODE_MOMENTARY_VEL:
+							if (lastValueIn[id] != valuesNote[note]) {
+								t = valuesNote[note];
+								lastValueIn[id] = valuesNote[note];
+							}
+							break;
+						case NOTEMODE::NOTEMODE_TOGGLE:
+							if (valuesNote[note] > 0 && (lastValueIn[id] == -1 || lastValueIn[id] >= 0)) {
+								t = 127;
+								lastValueIn[id] = -2;
+							} 
+							else if (valuesNote[note] == 0 && lastValueIn[id] == -2) {
+								t = 127;
+								lastValueIn[id] = -3;
+							}
+							else if (valuesNote[note] > 0 && lastValueIn[id] == -3) {
+								t = 0;
+								lastValueIn[id] = -4;
+							}
+							else if (valuesNote[note] == 0 && lastValueIn[id] == -4) {
+								t = 0;
+								lastValueIn[id] = -1;
+							}
+							break;
+					}
+
+					if (t >= 0) {
+						float v = rescale(t, 0.f, 127.f, paramQuantity->getMinValue(), paramQuantity->getMaxValue());
+						// Do not use filters on notes
+						paramQuantity->setValue(v);
+					}
+				}
 
-					case MIDIMODE::MIDIMODE_LOCATE: {
-						bool indicate = false;
-						if ((cc >= 0 && valuesCc[cc] >= 0) && lastValueInIndicate[id] != valuesCc[cc]) {
-							lastValueInIndicate[id] = valuesCc[cc];
-							indicate = true;
-						}
-						if ((note >= 0 && valuesNote[note] >= 0) && lastValueInIndicate[id] != valuesNote[note]) {
-							lastValueInIndicate[id] = valuesNote[note];
-							indicate = true;
+				// Midi feedback
+				float v = paramQuantity->getValue();
+				if (lastValueOut[id] != v) {
+					lastValueOut[id] = v;
+					v = rescale(v, paramQuantity->getMinValue(), paramQuantity->getMaxValue(), 0.f, 127.f);
+					if (cc >= 0 && ccsMode[id] == CCMODE_DIRECT) {
+						lastValueIn[id] = v;
+						// Other channels bound to the same CC follow the new value
+						if (valuesCc[cc] != lastValueIn[id]) {
+							valuesCc[cc] = lastValueIn[id];
+							markDirtyCc(cc);
 						}
-						if (indicate) {
-							ModuleWidget *mw = APP->scene->rack->getModule(paramQuantity->module->id);
-							paramHandleIndicator[id].indicate(mw);
-						}
-					} break;
+					}
+					if (cc >= 0)
+						midiOutput.setValue(v, cc);
+					if (note >= 0)
+						midiOutput.setGate(v, note);
 				}
-			}
-		}
+			} break;
 
-		if (indicatorDivider.process()) {
-			float t = indicatorDivider.getDivision() * args.sampleTime;
-			for (int i = 0; i < mapLen; i++) {
-				paramHandleIndicator[i].color = mappingIndicatorHidden ? color::BLACK_TRANSPARENT : mappingIndicatorColor;
-				if (paramHandles[i].moduleId >= 0) {
-					paramHandleIndicator[i].process(t);
+			case MIDIMODE::MIDIMODE_LOCATE: {
+				bool indicate = false;
+				if ((cc >= 0 && valuesCc[cc] >= 0) && lastValueInIndicate[id] != valuesCc[cc]) {
+					lastValueInIndicate[id] = valuesCc[cc];
+					indicate = true;
 				}
-			}
+				if ((note >= 0 && valuesNote[note] >= 0) && lastValueInIndicate[id] != valuesNote[note]) {
+					lastValueInIndicate[id] = valuesNote[note];
+					indicate = true;
+				}
+				if (indicate) {
+					ModuleWidget *mw = APP->scene->rack->getModule(paramQuantity->module->id);
+					paramHandleIndicator[id].indicate(mw);
+				}
+			} break;
 		}
 	}
 
@@ -415,10 +581,13 @@ struct MidiCatModule : Module {
 			learnedCc = true;
 			commitLearn();
 			updateMapLen();
+			rebuildIndex();
 			refreshParamHandleText(learningId);
 		}
 		bool changed = valuesCc[cc] != value;
 		valuesCc[cc] = value;
+		if (changed)
+			markDirtyCc(cc);
 		return changed;
 	}
 
@@ -433,10 +602,13 @@ struct MidiCatModule : Module {
 			learnedNote = true;
 			commitLearn();
 			updateMapLen();
+			rebuildIndex();
 			refreshParamHandleText(learningId);
 		}
 		bool changed = valuesNote[note] != vel;
 		valuesNote[note] = vel;
+		if (changed)
+			markDirtyNote(note);
 		return changed;
 	}
 
@@ -444,16 +616,97 @@ struct MidiCatModule : Module {
 		uint8_t note = msg.getNote();
 		bool changed = valuesNote[note] != 0;
 		valuesNote[note] = 0;
+		if (changed)
+			markDirtyNote(note);
 		return changed;
 	}
 
+	inline void markDirty(int id) {
+		if (dirty[id]) return;
+		dirty[id] = true;
+		dirtyIds[dirtyLen++] = id;
+	}
+
+	/** Marks all channels bound to a CC number */
+	inline void markDirtyCc(int cc) {
+		for (int id = ccFirstId[cc]; id >= 0; id = ccNextId[id])
+			markDirty(id);
+	}
+
+	/** Marks all channels bound to a note number */
+	inline void markDirtyNote(int note) {
+		for (int id = noteFirstId[note]; id >= 0; id = noteNextId[id])
+			markDirty(id);
+	}
+
+	inline void clearDirty() {
+		for (int i = 0; i < dirtyLen; i++) {
+			dirty[dirtyIds[i]] = false;
+		}
+		dirtyLen = 0;
+	}
+
+	/** Requests a rebuild of the reverse index, must be called when ccs or notes change */
+	void updateIndex() {
+		indexDirty = true;
+	}
+
+	/** Rebuilds the reverse index of CC and note numbers, engine-thread only as process() walks it */
+	void rebuildIndex() {
+		for (int i = 0; i < 128; i++) {
+			ccFirstId[i] = -1;
+			noteFirstId[i] = -1;
+		}
+		// Build the lists backwards so next-ids always point to higher ids
+		for (int id = MAX_CHANNELS - 1; id >= 0; id--) {
+			if (ccs[id] >= 0) {
+				ccNextId[id] = ccFirstId[ccs[id]];
+				ccFirstId[ccs[id]] = id;
+			}
+			if (notes[id] >= 0) {
+				noteNextId[id] = noteFirstId[notes[id]];
+				noteFirstId[notes[id]] = id;
+			}
+		}
+	}
+
+	/** Maps the handle of a channel, registers it with the engine on first use */
+	void bindParamHandle(int id, int moduleId, int paramId, bool overwrite) {
+		if (moduleId < 0) {
+			unbindParamHandle(id);
+			return;
+		}
+		if (!paramHandleRegistered[id]) {
+			APP->engine->addParamHandle(&paramHandles[id]);
+			paramHandleRegistered[id] = true;
+		}
+		APP->engine->updateParamHandle(&paramHandles[id], moduleId, paramId, overwrite);
+		mappingRegistry.update(this, id, &paramHandles[id]);
+	}
+
+	/** Unmaps the handle of a channel and removes it from the engine */
+	void unbindParamHandle(int id) {
+		if (!paramHandleRegistered[id])
+			return;
+		APP->engine->updateParamHandle(&paramHandles[id], -1, 0, true);
+		APP->engine->removeParamHandle(&paramHandles[id]);
+		paramHandleRegistered[id] = false;
+		mappingRegistry.remove(&paramHandles[id]);
+	}
+
 	void clearMap(int id) {
 		learningId = -1;
+		resetMap(id);
+		updateMapLen();
+	}
+
+	/** Removes CC, note, label and parameter of a slot, a running learn is not affected */
+	void resetMap(int id) {
 		ccs[id] = -1;
 		notes[id] = -1;
 		textLabel[id] = "";
-		APP->engine->updateParamHandle(&paramHandles[id], -1, 0, true);
-		updateMapLen();
+		unbindParamHandle(id);
+		updateIndex();
 		refreshParamHandleText(id);
 	}
 
@@ -463,10 +716,11 @@ struct MidiCatModule : Module {
 			ccs[id] = -1;
 			notes[id] = -1;
 			textLabel[id] = "";
-			APP->engine->updateParamHandle(&paramHandles[id], -1, 0, true);
+			unbindParamHandle(id);
 			refreshParamHandleText(id);
 		}
 		mapLen = 0;
+		updateIndex();
 	}
 
 	void updateMapLen() {
@@ -524,7 +778,12 @@ struct MidiCatModule : Module {
 	}
 
 	void learnParam(int id, int moduleId, int paramId) {
-		APP->engine->updateParamHandle(&paramHandles[id], moduleId, paramId, true);
+		// The engine unbinds a slot which mapped the parameter before, clear it completely so its
+		// CC or note does not keep controlling nothing
+		MappingEntry entry;
+		if (mappingRegistry.find(moduleId, paramId, &entry) && entry.owner == this && entry.slot != id)
+			resetMap(entry.slot);
+		bindParamHandle(id, moduleId, paramId, true);
 		//filterInitialized[id] = false;
 		//valueFilters[id].reset();
 		learnedParam = true;
@@ -572,6 +831,7 @@ struct MidiCatModule : Module {
 
 		json_object_set_new(rootJ, "midiInput", midiInput.toJson());
 		json_object_set_new(rootJ, "midiOutput", midiOutput.toJson());
+		json_object_set_new(rootJ, "midiOutputRateLimit", json_integer(midiOutput.rateLimit));
 		return rootJ;
 	}
 
@@ -606,7 +866,7 @@ struct MidiCatModule : Module {
 				if (!((ccJ || noteJ) && moduleIdJ && paramIdJ)) {
 					ccs[mapIndex] = -1;
 					notes[mapIndex] = -1;
-					APP->engine->updateParamHandle(&paramHandles[mapIndex], -1, 0, true);
+					unbindParamHandle(mapIndex);
 					continue;
 				}
 
@@ -617,7 +877,7 @@ struct MidiCatModule : Module {
 				int moduleId = json_integer_value(moduleIdJ);
 				int paramId = json_integer_value(paramIdJ);
 				if (moduleId != paramHandles[mapIndex].moduleId || paramId != paramHandles[mapIndex].paramId) {
-					APP->engine->updateParamHandle(&paramHandles[mapIndex], moduleId, paramId, false);
+					bindParamHandle(mapIndex, moduleId, paramId, false);
 					refreshParamHandleText(mapIndex);
 				}
 				if (labelJ) textLabel[mapIndex] = json_string_value(labelJ);
@@ -625,6 +885,7 @@ struct MidiCatModule : Module {
 		}
 
 		updateMapLen();
+		updateIndex();
 
 		json_t *midiInputJ = json_object_get(rootJ, "midiInput");
 		if (midiInputJ)
@@ -632,6 +893,9 @@ struct MidiCatModule : Module {
 		json_t *midiOutputJ = json_object_get(rootJ, "midiOutput");
 		if (midiOutputJ)
 			midiOutput.fromJson(midiOutputJ);
+		json_t* midiOutputRateLimitJ = json_object_get(rootJ, "midiOutputRateLimit");
+		if (midiOutputRateLimitJ)
+			midiOutput.setRateLimit(json_integer_value(midiOutputRateLimitJ));
 	}
 };
 
@@ -845,6 +1109,43 @@ struct MidiModeMenuItem : MenuItem {
 };
 
 
+struct FeedbackMenuItem : MenuItem {
+	MidiCatModule* module;
+
+	FeedbackMenuItem() {
+		rightText = RIGHT_ARROW;
+	}
+
+	struct RateLimitItem : MenuItem {
+		MidiCatModule* module;
+		int rateLimit;
+
+		void onAction(const event::Action& e) override {
+			module->midiOutput.setRateLimit(rateLimit);
+		}
+
+		void step() override {
+			rightText = module->midiOutput.rateLimit == rateLimit ? "✔" : "";
+			MenuItem::step();
+		}
+	};
+
+	Menu* createChildMenu() override {
+		Menu* menu = new Menu;
+		menu->addChild(construct<MenuLabel>(&MenuLabel::text, "Messages per second"));
+		menu->addChild(construct<RateLimitItem>(&MenuItem::text, "250", &RateLimitItem::module, module, &RateLimitItem::rateLimit, 250));
+		menu->addChild(construct<RateLimitItem>(&MenuItem::text, "500", &RateLimitItem::module, module, &RateLimitItem::rateLimit, 500));
+		menu->addChild(construct<RateLimitItem>(&MenuItem::text, "1000 (DIN MIDI)", &RateLimitItem::module, module, &RateLimitItem::rateLimit, 1000));
+		menu->addChild(construct<RateLimitItem>(&MenuItem::text, "3000", &RateLimitItem::module, module, &RateLimitItem::rateLimit, 3000));
+		menu->addChild(construct<RateLimitItem>(&MenuItem::text, "Unlimited", &RateLimitItem::module, module, &RateLimitItem::rateLimit, 0));
+		menu->addChild(new MenuSeparator());
+		menu->addChild(construct<MenuLabel>(&MenuLabel::text, string::f("Coalesced: %u", module->midiOutput.coalescedCount)));
+		menu->addChild(construct<MenuLabel>(&MenuLabel::text, string::f("Dropped: %u", module->midiOutput.droppedCount)));
+		return menu;
+	}
+};
+
+
 struct MidiCatMidiWidget : MidiWidget {
 	void setMidiPort(midi::Port *port) {
 		MidiWidget::setMidiPort(port);
@@ -1023,6 +1324,7 @@ struct MidiCatWidget : ThemedModuleWidget<MidiCatModule> {
 
 		menu->addChild(new MenuSeparator());
 		menu->addChild(construct<MidiModeMenuItem>(&MenuItem::text, "Mode", &MidiModeMenuItem::module, module));
+		menu->addChild(construct<FeedbackMenuItem>(&MenuItem::text, "MIDI feedback", &FeedbackMenuItem::module, module));
 		menu->addChild(construct<TextScrollItem>(&MenuItem::text, "Text scrolling", &TextScrollItem::module, module));
 		menu->addChild(construct<MappingIndicatorHiddenItem>(&MenuItem::text, "Hide mapping indicators", &MappingIndicatorHiddenItem::module, module));
 		menu->addChild(construct<LockedItem>(&MenuItem::text, "Lock mapping slots", &LockedItem::module, module));
@@ -43,48 +43,50 @@ struct MirrorModule : Module {
 	std::vector<ParamHandle*> sourceHandles;
 	/** [Stored to JSON] */
 	std::vector<ParamHandle*> targetHandles;
+	/** Blocks of contiguous storage the source and target handles point into */
+	std::vector<ParamHandle*> handlePools;
 	/** [Stored to JSON] */
 	int cvParamId[8];
 
+	/** Snapshot of the last propagated value of each source parameter */
+	std::vector<float> sourceValues;
+	/** Set if a source parameter must be propagated regardless of its snapshot */
+	std::vector<uint8_t> sourceDirty;
+	/** Resolved source parameters, revalidated against the handle's module */
+	std::vector<Module*> sourceModules;
+	std::vector<ParamQuantity*> sourceParamQuantities;
+	/** Resolved target parameters grouped by source, index = source * targetCount + target */
+	std::vector<Module*> targetModules;
+	std::vector<ParamQuantity*> targetParamQuantities;
+	size_t targetCount = 0;
+
 	dsp::ClockDivider processDivider;
 	dsp::ClockDivider handleDivider;
+	int profileRevision = -1;
+
+	ProcessProfiler profiler;
 
 	MirrorModule() {
 		panelTheme = pluginSettings.panelThemeDefault;
 		config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
+		profiler.attach(this);
 
-		processDivider.setDivision(32);
-		handleDivider.setDivision(4096);
+		applyProfile();
 		onReset();
 	}
 
 	~MirrorModule() {
-		for (ParamHandle* sourceHandle : sourceHandles) {
-			APP->engine->removeParamHandle(sourceHandle);
-			delete sourceHandle;
-		}
-		for (ParamHandle* targetHandle : targetHandles) {
-			APP->engine->removeParamHandle(targetHandle);
-			delete targetHandle;
-		}
+		disposeHandles();
 	}
 
 	void onReset() override {
 		inChange = true;
-		for (ParamHandle* sourceHandle : sourceHandles) {
-			APP->engine->removeParamHandle(sourceHandle);
-			delete sourceHandle;
-		}
-		sourceHandles.clear();
-		for (ParamHandle* targetHandle : targetHandles) {
-			APP->engine->removeParamHandle(targetHandle);
-			delete targetHandle;
-		}
-		targetHandles.clear();
+		disposeHandles();
 
 		for (int i = 0; i < 8; i++) {
 			cvParamId[i] = -1;
 		}
+		updateCache();
 		inChange = false;
 
 		sourcePluginSlug = "";
@@ -95,8 +97,17 @@ struct MirrorModule : Module {
 		audioRate = false;
 	}
 
+	void applyProfile() {
+		profileRevision = pluginSettings.profileRevision;
+		processDivider.setDivision(pluginSettings.controlDivision(32));
+		handleDivider.setDivision(pluginSettings.controlDivision(4096));
+	}
+
 	void process(const ProcessArgs& args) override {
+		if (profileRevision != pluginSettings.profileRevision)
+			applyProfile();
 		if (inChange) return;
+		int64_t profileStart = profiler.begin();
 
 		// Sync source paramId to target handles in case a parameter has been unmapped
 		if (handleDivider.process()) {
@@ -108,10 +119,14 @@ struct MirrorModule : Module {
 					ParamHandle* targetHandle = targetHandles[j];
 					targetHandle->color = mappingIndicatorHidden ? color::BLACK_TRANSPARENT : nvgRGB(0xff, 0x40, 0xff);
 					if (sourceHandle->moduleId < 0 && targetHandle->moduleId >= 0) {
-						APP->engine->updateParamHandle(targetHandle, sourceHandle->moduleId, sourceHandle->paramId, true);
+						// Don't update the handle from the engine-thread, defer it to the app-thread.
+						// If the queue is full the handle is still unmapped on the next pass.
+						engineQueue.pushParamHandleUpdate(targetHandle, sourceHandle->moduleId, sourceHandle->paramId, true);
 					}
 					j += sourceHandles.size();
 				}
+				// Periodically propagate all parameters to restore targets changed by hand
+				sourceDirty[i] = 1;
 			}
 		}
 
@@ -119,8 +134,7 @@ struct MirrorModule : Module {
 			for (int i = 0; i < 8; i++) {
 				if (cvParamId[i] >= 0 && inputs[INPUT_CV + i].isConnected()) {
 					float v = clamp(inputs[INPUT_CV + i].getVoltage(), 0.f, 10.f);
-					ParamHandle* sourceHandle = sourceHandles[cvParamId[i]];
-					ParamQuantity* sourceParamQuantity = getParamQuantity(sourceHandle);
+					ParamQuantity* sourceParamQuantity = getSourceParamQuantity(cvParamId[i]);
 					if (sourceParamQuantity) 
 						sourceParamQuantity->setScaledValue(v / 10.f);
 					else 
@@ -128,23 +142,24 @@ struct MirrorModule : Module {
 				}
 			}
 
-			for (ParamHandle* sourceHandle : sourceHandles) {
-				ParamQuantity* sourceParamQuantity = getParamQuantity(sourceHandle);
+			for (size_t i = 0; i < sourceHandles.size(); i++) {
+				ParamQuantity* sourceParamQuantity = getSourceParamQuantity(i);
 				if (!sourceParamQuantity) continue;
 
 				float v = sourceParamQuantity->getValue();
+				if (!sourceDirty[i] && v == sourceValues[i]) continue;
+				sourceValues[i] = v;
+				sourceDirty[i] = 0;
 
-				int i = sourceHandle->paramId;
-				while (i < (int)targetHandles.size()) {
-					ParamHandle* targetHandle = targetHandles[i];
-					ParamQuantity* targetParamQuantity = getParamQuantity(targetHandle);
+				// Only changed parameters are written to the targets
+				for (size_t k = 0; k < targetCount; k++) {
+					ParamQuantity* targetParamQuantity = getTargetParamQuantity(i, k);
 					if (targetParamQuantity) 
 						targetParamQuantity->setValue(v);
-
-					i += sourceHandles.size();
 				}
 			}
 		}
+		profiler.end(ProcessProfiler::SECTION_CONTROL, profileStart);
 	}
 
 	ParamQuantity* getParamQuantity(ParamHandle* handle) {
@@ -162,6 +177,69 @@ struct MirrorModule : Module {
 		return paramQuantity;
 	}
 
+	/** Allocates a contiguous block of handles and registers all of them with the engine */
+	ParamHandle* allocateHandles(size_t count) {
+		ParamHandle* pool = new ParamHandle[count];
+		handlePools.push_back(pool);
+		for (size_t i = 0; i < count; i++) {
+			pool[i].text = "stoermelder MIRROR";
+			APP->engine->addParamHandle(&pool[i]);
+		}
+		return pool;
+	}
+
+	void disposeHandles() {
+		// Apply pending updates before any handle is deleted
+		engineQueue.process();
+		for (ParamHandle* sourceHandle : sourceHandles) {
+			APP->engine->removeParamHandle(sourceHandle);
+		}
+		sourceHandles.clear();
+		for (ParamHandle* targetHandle : targetHandles) {
+			APP->engine->removeParamHandle(targetHandle);
+		}
+		targetHandles.clear();
+		for (ParamHandle* pool : handlePools) {
+			delete[] pool;
+		}
+		handlePools.clear();
+	}
+
+	/** Rebuilds the layout of the resolved caches, must be called whenever handles are added or removed */
+	void updateCache() {
+		size_t sourceCount = sourceHandles.size();
+		targetCount = sourceCount > 0 ? targetHandles.size() / sourceCount : 0;
+		sourceValues.assign(sourceCount, 0.f);
+		sourceDirty.assign(sourceCount, 1);
+		sourceModules.assign(sourceCount, NULL);
+		sourceParamQuantities.assign(sourceCount, NULL);
+		targetModules.assign(sourceCount * targetCount, NULL);
+		targetParamQuantities.assign(sourceCount * targetCount, NULL);
+	}
+
+	inline ParamQuantity* getSourceParamQuantity(size_t i) {
+		ParamHandle* sourceHandle = sourceHandles[i];
+		if (sourceHandle->module != sourceModules[i]) {
+			sourceModules[i] = sourceHandle->module;
+			sourceParamQuantities[i] = getParamQuantity(sourceHandle);
+			sourceDirty[i] = 1;
+		}
+		return sourceParamQuantities[i];
+	}
+
+	inline ParamQuantity* getTargetParamQuantity(size_t i, size_t k) {
+		// Target handles are stored with a stride of the source count
+		ParamHandle* targetHandle = targetHandles[k * sourceHandles.size() + i];
+		size_t j = i * targetCount + k;
+		if (targetHandle->module != targetModules[j]) {
+			targetModules[j] = targetHandle->module;
+			targetParamQuantities[j] = getParamQuantity(targetHandle);
+			// A newly resolved target needs the current value
+			sourceDirty[i] = 1;
+		}
+		return targetParamQuantities[j];
+	}
+
 	void bindToSource() {
 		Expander* exp = &leftExpander;
 		if (exp->moduleId < 0) return;
@@ -175,14 +253,15 @@ struct MirrorModule : Module {
 		sourceModelName = m->model->name;
 		sourceModuleId = m->id;
 
+		ParamHandle* pool = allocateHandles(m->params.size());
+		sourceHandles.reserve(m->params.size());
 		for (size_t i = 0; i < m->params.size(); i++) {
-			ParamHandle* sourceHandle = new ParamHandle;
-			sourceHandle->text = "stoermelder MIRROR";
-			APP->engine->addParamHandle(sourceHandle);
+			ParamHandle* sourceHandle = &pool[i];
 			APP->engine->updateParamHandle(sourceHandle, m->id, i, true);
 			sourceHandles.push_back(sourceHandle);
 		}
 
+		updateCache();
 		inChange = false;
 	}
 
@@ -194,13 +273,14 @@ struct MirrorModule : Module {
 		if (sourcePluginSlug != m->model->plugin->slug || sourceModelSlug != m->model->slug) return;
 
 		inChange = true;
-		for (ParamHandle* sourceHandle : sourceHandles) {
-			ParamHandle* targetHandle = new ParamHandle;
-			targetHandle->text = "stoermelder MIRROR";
-			APP->engine->addParamHandle(targetHandle);
-			APP->engine->updateParamHandle(targetHandle, m->id, sourceHandle->paramId, true);
+		ParamHandle* pool = allocateHandles(sourceHandles.size());
+		targetHandles.reserve(targetHandles.size() + sourceHandles.size());
+		for (size_t i = 0; i < sourceHandles.size(); i++) {
+			ParamHandle* targetHandle = &pool[i];
+			APP->engine->updateParamHandle(targetHandle, m->id, sourceHandles[i]->paramId, true);
 			targetHandles.push_back(targetHandle);
 		}
+		updateCache();
 		inChange = false;
 	}
 
@@ -277,15 +357,14 @@ struct MirrorModule : Module {
 		inChange = true;
 		json_t* sourceMapsJ = json_object_get(rootJ, "sourceMaps");
 		if (sourceMapsJ) {
+			ParamHandle* pool = allocateHandles(json_array_size(sourceMapsJ));
 			json_t* sourceMapJ;
 			size_t sourceMapIndex;
 			json_array_foreach(sourceMapsJ, sourceMapIndex, sourceMapJ) {
 				json_t* moduleIdJ = json_object_get(sourceMapJ, "moduleId");
 				json_t* paramIdJ = json_object_get(sourceMapJ, "paramId");
 
-				ParamHandle* sourceHandle = new ParamHandle;
-				sourceHandle->text = "stoermelder MIRROR";
-				APP->engine->addParamHandle(sourceHandle);
+				ParamHandle* sourceHandle = &pool[sourceMapIndex];
 				APP->engine->updateParamHandle(sourceHandle, json_integer_value(moduleIdJ), json_integer_value(paramIdJ), false);
 				sourceHandles.push_back(sourceHandle);
 			}
@@ -293,15 +372,14 @@ struct MirrorModule : Module {
 
 		json_t* targetMapsJ = json_object_get(rootJ, "targetMaps");
 		if (targetMapsJ) {
+			ParamHandle* pool = allocateHandles(json_array_size(targetMapsJ));
 			json_t* targetMapJ;
 			size_t targetMapIndex;
 			json_array_foreach(targetMapsJ, targetMapIndex, targetMapJ) {
 				json_t* moduleIdJ = json_object_get(targetMapJ, "moduleId");
 				json_t* paramIdJ = json_object_get(targetMapJ, "paramId");
 
-				ParamHandle* targetHandle = new ParamHandle;
-				targetHandle->text = "stoermelder MIRROR";
-				APP->engine->addParamHandle(targetHandle);
+				ParamHandle* targetHandle = &pool[targetMapIndex];
 				APP->engine->updateParamHandle(targetHandle, json_integer_value(moduleIdJ), json_integer_value(paramIdJ), false);
 				targetHandles.push_back(targetHandle);
 			}
@@ -317,6 +395,7 @@ struct MirrorModule : Module {
 			}
 		}
 
+		updateCache();
 		inChange = false;
 	}
 };
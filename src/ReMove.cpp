@@ -1,14 +1,13 @@
 #include "plugin.hpp"
 #include "MapModuleBase.hpp"
+#include "ReMoveStorage.hpp"
 #include <thread>
 #include <random>
+#include <atomic>
 
 
 namespace ReMove {
 
-const int REMOVE_MAX_DATA = 64 * 1024;
-const int REMOVE_MAX_SEQ = 8;
-
 enum RECMODE {
     RECMODE_TOUCH = 0,
     RECMODE_MOVE = 1,
@@ -16,6 +15,19 @@ enum RECMODE {
     RECMODE_SAMPLEHOLD = 3
 };
 
+enum TOUCHSTATE {
+    TOUCHSTATE_NONE = 0,
+    TOUCHSTATE_OTHER = 1,
+    TOUCHSTATE_PARAM = 2
+};
+
+enum DECIMATESTATE {
+    DECIMATESTATE_OFF = 0,
+    DECIMATESTATE_LINEAR = 1,
+    DECIMATESTATE_CUBIC = 2,
+    DECIMATESTATE_MOVE = 3
+};
+
 enum SEQCVMODE {
     SEQCVMODE_10V = 0,
     SEQCVMODE_C4 = 1,
@@ -60,8 +72,7 @@ const int REMOVE_PLAYDIR_FWD = 1;
 const int REMOVE_PLAYDIR_REV = -1;
 const int REMOVE_PLAYDIR_NONE = 0;
 
-
-struct ReMoveModule : MapModuleBase<1> {
+struct ReMoveModule : MapModuleBase<REMOVE_MAX_LANES> {
     enum ParamIds {
         RUN_PARAM,
         RESET_PARAM,
@@ -96,19 +107,26 @@ struct ReMoveModule : MapModuleBase<1> {
     /** [Stored to JSON] */
     int panelTheme = 0;
 
-    /** [Stored to JSON] recorded data */
-    float *seqData;
-    /** stores the current position in data */
+    /** [Stored to JSON] recorded data, used only by the engine thread */
+    ReMoveStorage *storage;
+    /** storage built on the UI thread, swapped in by process() */
+    std::atomic<ReMoveStorage*> storagePending{NULL};
+    /** storage swapped out by process(), freed on the UI thread */
+    std::atomic<ReMoveStorage*> storageRetired{NULL};
+    /** storage used by process(), for readers on the UI thread */
+    std::atomic<ReMoveStorage*> storageActive{NULL};
+    /** set while the engine thread writes the module to JSON */
+    bool jsonFromEngine = false;
+    /** stores the current position in the current sequence */
     int dataPtr = 0;
 
-    /** [Stored to JSON] number of sequences */
+    /** number of recorded parameters, the samples of all lanes are interleaved, copied from the storage */
+    int lanes = 1;
+
+    /** number of sequences, copied from the storage */
     int seqCount = 4;
     /** [Stored to JSON] currently selected sequence */
     int seq = 0;
-    int seqLow;
-    int seqHigh;
-    /** [Stored to JSON] length of the seqences */
-    int seqLength[REMOVE_MAX_SEQ];
 
     /** [Stored to JSON] mode for SEQ CV input, 0 = 0-10V, 1 = C4-G4, 2 = Trig */
     SEQCVMODE seqCvMode = SEQCVMODE_10V;
@@ -129,7 +147,7 @@ struct ReMoveModule : MapModuleBase<1> {
     /** [Stored to JSON] recording mode */
     RECMODE recMode = RECMODE_TOUCH;
     bool recTouched = false;
-    float recTouch;
+    float recTouch[REMOVE_MAX_LANES];
     /** [Stored to JSON] autoplay after record */
     bool recAutoplay;
 
@@ -144,6 +162,20 @@ struct ReMoveModule : MapModuleBase<1> {
     /** [Stored to JSON] mode for playback */
     PLAYMODE playMode = PLAYMODE_LOOP;
     int playDir = REMOVE_PLAYDIR_FWD;
+    /** [Stored to JSON] interpolation between samples on playback */
+    INTERPOLATION interpolation = INTERPOLATION_NONE;
+    /** [Stored to JSON] reduce the number of samples after recording as far as the interpolation allows */
+    bool recDecimate = false;
+    /** step of the decimation after recording, the pass is spread over several calls of process() */
+    DECIMATESTATE decimateState = DECIMATESTATE_OFF;
+    /** highest decimation verified so far */
+    int decimateFactor = 1;
+    /** next frame to be verified or moved */
+    int decimateFrame = 0;
+    /** last two samples of playback, used as starting point of the interpolation */
+    float playPrev[REMOVE_MAX_LANES];
+    float playFrom[REMOVE_MAX_LANES];
+    bool playFromValid = false;
 
     std::default_random_engine randGen{(uint16_t)std::chrono::system_clock::now().time_since_epoch().count()};
     std::uniform_int_distribution<int> randDist{0, REMOVE_MAX_SEQ - 1};
@@ -163,12 +195,12 @@ struct ReMoveModule : MapModuleBase<1> {
     dsp::BooleanTrigger recTrigger;
     dsp::PulseGenerator outCvPulse;
 
-    dsp::SlewLimiter slewLimiter;
+    dsp::SlewLimiter slewLimiter[REMOVE_MAX_LANES];
 
 	dsp::ClockDivider lightDivider;
 
-    /** last touched parameter to avoid frequent dynamic casting */
-    Widget *lastParamWidget;
+    /** widget dragged by the mouse, published by the module widget on the UI thread */
+    std::atomic<TOUCHSTATE> touchState{TOUCHSTATE_NONE};
 
     /** history-item when starting recording */
     history::ModuleChange *recChangeHistory = NULL;
@@ -183,16 +215,23 @@ struct ReMoveModule : MapModuleBase<1> {
         configParam<TriggerParamQuantity>(REC_PARAM, 0.0f, 1.0f, 0.0f, "Record");
         configParam(SLEW_PARAM, 0.0f, 0.975f, 0.0f, "Slew");
 
-        seqData = new float[REMOVE_MAX_DATA];
         this->mappingIndicatorColor = nvgRGB(0x40, 0xff, 0xff);
-        paramHandles[0].text = "ReMove Lite";
+        for (int i = 0; i < REMOVE_MAX_LANES; i++) {
+            paramHandles[i].text = "ReMove Lite";
+        }
 
         lightDivider.setDivision(1024);
+        storage = new ReMoveStorage;
+        storage->allocate = false;
+        storage->fill(REMOVE_POOL_IDLE);
+        storageActive.store(storage);
         onReset();
     }
 
     ~ReMoveModule() {
-        delete[] seqData;
+        delete storage;
+        delete storagePending.load();
+        delete storageRetired.load();
     }
 
     void onReset() override {
@@ -202,22 +241,27 @@ struct ReMoveModule : MapModuleBase<1> {
         isRecording = false;
         recTouched = false;
         recAutoplay = false;
+        recDecimate = false;
+        interpolation = INTERPOLATION_NONE;
         dataPtr = 0;
         sampleTimer.reset();
         seq = 0;
-        seqResize(4);
-        valueFilters[0].reset();
+        storageReset(1, 4);
+        for (int i = 0; i < REMOVE_MAX_LANES; i++) {
+            valueFilters[i].reset();
+        }
     }
 
     void process(const ProcessArgs &args) override {
+        if (storagePending.load(std::memory_order_relaxed)) storageSwap();
         engineSampleTime = args.sampleTime;
         outputs[REC_OUTPUT].setVoltage(0);
+        outputs[CV_OUTPUT].setChannels(outCvMode == OUTCVMODE_EOC ? 1 : lanes);
 
         // Toggle record when button is pressed
-        if (recTrigger.process(params[REC_PARAM].getValue() + inputs[REC_INPUT].getVoltage())) {
+        if (recTrigger.process(params[REC_PARAM].getValue() + inputs[REC_INPUT].getVoltage()) && decimateState == DECIMATESTATE_OFF) {
             isPlaying = false;
-            ParamQuantity *paramQuantity = getParamQuantity(0);
-            if (paramQuantity != NULL) {
+            if (isMapped()) {
                 isRecording ^= true;
                 if (isRecording) {
                     startRecording();
@@ -229,24 +273,17 @@ struct ReMoveModule : MapModuleBase<1> {
             }
         }
 
-        if (isRecording) {
+        if (decimateState != DECIMATESTATE_OFF) {
+            processDecimation();
+        }
+        else if (isRecording) {
             bool doRecord = true;
 
             if (recMode == RECMODE_TOUCH && !recTouched) {
                 // check if mouse has been pressed on parameter
-                Widget *w = APP->event->getDraggedWidget();
-                if (w != NULL && w != lastParamWidget) {
-                    lastParamWidget = w;
-                    // it is not a good idea to do dynamic casting in the DSP thread,
-                    // so do this only once for each touched widget
-                    ParamWidget *pw = dynamic_cast<ParamWidget*>(w);
-                    if (pw != NULL && pw->paramQuantity == getParamQuantity(0)) {
-                        recTouched = true;
-                        recOutCvPulse.trigger();
-                    }
-                    else {
-                        doRecord = false;
-                    }
+                if (touchState == TOUCHSTATE_PARAM) {
+                    recTouched = true;
+                    recOutCvPulse.trigger();
                 }
                 else {
                     doRecord = false;
@@ -254,12 +291,14 @@ struct ReMoveModule : MapModuleBase<1> {
             }
 
             if (recMode == RECMODE_MOVE && !recTouched) {
-                // check if param value has changed
-                if (getValue() != recTouch) {
-                    recTouched = true;
-                    recOutCvPulse.trigger();
+                // check if any param value has changed
+                for (int i = 0; i < lanes && !recTouched; i++) {
+                    if (getValue(i) != recTouch[i]) {
+                        recTouched = true;
+                        recOutCvPulse.trigger();
+                    }
                 }
-                else {
+                if (!recTouched) {
                     doRecord = false;
                 }
             }
@@ -267,39 +306,43 @@ struct ReMoveModule : MapModuleBase<1> {
             if (doRecord) {
                 if (sampleTimer.process(args.sampleTime) > sampleRate) {
                     // check if mouse button has been released
-                    if (APP->event->getDraggedWidget() == NULL) {
+                    if (touchState == TOUCHSTATE_NONE) {
                         if (recMode == RECMODE_TOUCH) {
                             stopRecording();
                         }
                         if (recMode == RECMODE_MOVE) {
-                            stopRecording();
                             // trim unchanged values from the end
-                            int i = seqLow + seqLength[seq] - 1;
-                            if (i > seqLow) {
-                                float l = seqData[i];
-                                while (i > seqLow && l == seqData[i - 1]) i--;
-                                seqLength[seq] = i - seqLow;
+                            int i = storage->seqLength[seq] - 1;
+                            if (i > 0) {
+                                float *l = storage->frame(seq, i * lanes);
+                                while (i > 0 && std::equal(l, l + lanes, storage->frame(seq, (i - 1) * lanes))) i--;
+                                storage->seqLength[seq] = i;
                             }
+                            stopRecording();
                         } 
                     }
                     
                     // Are we still recording?
-                    if (isRecording) {
-                        seqData[dataPtr] = getValue();
+                    // Stop recording when the storage is used up
+                    if (isRecording && !storage->reserve(seq, dataPtr * lanes)) {
+                        stopRecording();
+                    }
 
-                        // Push value on parameter only when CV input is been used
-                        ParamQuantity* paramQuantity = NULL;
-                        if (inputs[CV_INPUT].isConnected()) paramQuantity = getParamQuantity(0);
-                        setValue(seqData[dataPtr], paramQuantity);
-                        seqLength[seq]++;
-                        dataPtr++;
-                        // Stop recording when end of sequence is reached
-                        if (dataPtr == seqHigh) {
-                            stopRecording();
+                    if (isRecording) {
+                        float *frame = storage->frame(seq, dataPtr * lanes);
+                        // Push values on parameters only when CV input is been used
+                        bool cvInput = inputs[CV_INPUT].isConnected();
+                        for (int i = 0; i < lanes; i++) {
+                            frame[i] = getValue(i);
+                            setValue(i, frame[i], cvInput ? getParamQuantity(i) : NULL, sampleRate);
                         }
+                        storage->seqLength[seq]++;
+                        dataPtr++;
                         if (recMode == RECMODE_SAMPLEHOLD) {
-                            seqData[dataPtr] = seqData[dataPtr - 1];
-                            seqLength[seq]++;
+                            if (storage->reserve(seq, dataPtr * lanes)) {
+                                std::copy(frame, frame + lanes, storage->frame(seq, dataPtr * lanes));
+                                storage->seqLength[seq]++;
+                            }
                             stopRecording();
                         }
                     }
@@ -324,10 +367,12 @@ struct ReMoveModule : MapModuleBase<1> {
 
             // RESET-input: reset ptr when button is pressed or input is triggered
             if (resetCvTrigger.process(params[RESET_PARAM].getValue() + inputs[RESET_INPUT].getVoltage())) {
-                dataPtr = seqLow;
+                dataPtr = 0;
                 playDir = REMOVE_PLAYDIR_FWD;
                 sampleTimer.reset();
-                valueFilters[0].reset();
+                for (int i = 0; i < lanes; i++) {
+                    valueFilters[i].reset();
+                }
                 resetCvTimer.reset();
             }
 
@@ -369,30 +414,39 @@ struct ReMoveModule : MapModuleBase<1> {
             // PHASE-input: if position-input is connected set the position directly, ignore playing
             if (inputs[PHASE_INPUT].isConnected()) {
                 isPlaying = false;
-                ParamQuantity *paramQuantity = getParamQuantity(0);
-                if (paramQuantity != NULL) {
+                if (isMapped() && storage->seqLength[seq] > 0) {
                     float v = clamp(inputs[PHASE_INPUT].getVoltage(), 0.f, 10.f);
-                    dataPtr = floor(rescale(v, 0.f, 10.f, seqLow, seqLow + seqLength[seq] - 1));
-                    v = seqData[dataPtr];
-                    setValue(v, paramQuantity);
+                    dataPtr = floor(rescale(v, 0.f, 10.f, 0, storage->seqLength[seq] - 1));
+                    float *frame = storage->frame(seq, dataPtr * lanes);
+                    for (int i = 0; i < lanes; i++) {
+                        setValue(i, frame[i], getParamQuantity(i), sampleRate);
+                    }
                 }
             }
 
             if (isPlaying) {
-                if (sampleTimer.process(args.sampleTime) > sampleRate) {
-                    ParamQuantity *paramQuantity = getParamQuantity(0);
-                    if (paramQuantity == NULL)
+                float samplePeriod = sampleRate * storage->seqDecimation[seq];
+                INTERPOLATION playInterpolation = getInterpolation();
+                if (sampleTimer.process(args.sampleTime) > samplePeriod) {
+                    if (!isMapped())
                         isPlaying = false;
 
                     // are we still playing?
-                    if (isPlaying && seqLength[seq] > 0) {
-                        float v = seqData[dataPtr];
+                    if (isPlaying && storage->seqLength[seq] > 0) {
+                        float *frame = storage->frame(seq, dataPtr * lanes);
                         dataPtr = dataPtr + playDir;
-                        setValue(v, paramQuantity);
-                        if (dataPtr == seqLow + seqLength[seq] && playDir == REMOVE_PLAYDIR_FWD) {
+                        // Interpolated values are set on every sample, so slew over one sample only
+                        float dt = playInterpolation == INTERPOLATION_NONE ? samplePeriod : args.sampleTime;
+                        for (int i = 0; i < lanes; i++) {
+                            playPrev[i] = playFromValid ? playFrom[i] : frame[i];
+                            playFrom[i] = frame[i];
+                            setValue(i, frame[i], getParamQuantity(i), dt);
+                        }
+                        playFromValid = true;
+                        if (dataPtr == storage->seqLength[seq] && playDir == REMOVE_PLAYDIR_FWD) {
                             switch (playMode) {
                                 case PLAYMODE_LOOP: 
-                                    dataPtr = seqLow; break;
+                                    dataPtr = 0; break;
                                 case PLAYMODE_ONESHOT:      // stay on last value
                                     dataPtr--; playDir = REMOVE_PLAYDIR_NONE; break;
                                 case PLAYMODE_PINGPONG:     // reverse direction
@@ -403,18 +457,25 @@ struct ReMoveModule : MapModuleBase<1> {
                                     seqRand(); break;
                             }
                         }
-                        if (dataPtr == seqLow - 1) {
+                        if (dataPtr == -1) {
                             dataPtr++; playDir = REMOVE_PLAYDIR_FWD;
                         }
                     }
                     sampleTimer.reset();
                 }
+                else if (playInterpolation != INTERPOLATION_NONE && playFromValid && dataPtr >= 0 && dataPtr < storage->seqLength[seq]) {
+                    processInterpolation(playInterpolation, args.sampleTime, samplePeriod);
+                }
                 processSetValue();
             }
             else {
+                playFromValid = false;
                 // Not playing and not recording -> bypass input to output for empty sequences
-                if (seqLength[seq] == 0)
-                    setValue(getValue());
+                if (storage->seqLength[seq] == 0) {
+                    for (int i = 0; i < lanes; i++) {
+                        setValue(i, getValue(i), NULL, sampleRate);
+                    }
+                }
             }
         }
 
@@ -447,34 +508,50 @@ struct ReMoveModule : MapModuleBase<1> {
         MapModuleBase::process(args);
     }
 
-    inline float getValue() {
+    /** Returns whether any lane is mapped to a parameter */
+    inline bool isMapped() {
+        for (int i = 0; i < lanes; i++) {
+            if (getParamQuantity(i)) return true;
+        }
+        return false;
+    }
+
+    /** Returns whether a parameter is mapped to any lane, only compares the ids of the handles */
+    bool isLane(int moduleId, int paramId) {
+        for (int i = 0; i < lanes; i++) {
+            if (paramHandles[i].moduleId == moduleId && paramHandles[i].paramId == paramId) return true;
+        }
+        return false;
+    }
+
+    /** Returns the value of a lane, taken from the channel of the IN-port if connected */
+    inline float getValue(int lane) {
         float v = 0.f;
         if (inputs[CV_INPUT].isConnected()) {
             switch (inCvMode) {
                 case INCVMODE_UNI:
-                    v = rescale(clamp(inputs[CV_INPUT].getVoltage(), 0.f, 10.f), 0.f, 10.f, 0.f, 1.f);
+                    v = rescale(clamp(inputs[CV_INPUT].getPolyVoltage(lane), 0.f, 10.f), 0.f, 10.f, 0.f, 1.f);
                     break;
                 case INCVMODE_BI:
-                    v = rescale(clamp(inputs[CV_INPUT].getVoltage(), -5.f, 5.f), -5.f, 5.f, 0.f, 1.f);
+                    v = rescale(clamp(inputs[CV_INPUT].getPolyVoltage(lane), -5.f, 5.f), -5.f, 5.f, 0.f, 1.f);
                     break;
             }
         }
         else {
-            ParamQuantity *paramQuantity = getParamQuantity(0);
+            ParamQuantity *paramQuantity = getParamQuantity(lane);
             if (paramQuantity) {
                 v = paramQuantity->getScaledValue();
-                v = valueFilters[0].process(engineSampleTime, v);
+                v = valueFilters[lane].process(engineSampleTime, v);
             }
         }
         return v;
     }
 
-    inline void setValue(float v, ParamQuantity *paramQuantity = NULL) {
-        //v = valueFilters[0].process(sampleTime, v);
+    inline void setValue(int lane, float v, ParamQuantity *paramQuantity, float dt) {
         if (params[SLEW_PARAM].getValue() > 0.f) {
             float s = 100.f * (1.f - params[SLEW_PARAM].getValue());
-            slewLimiter.setRiseFall(s, s);
-            v = slewLimiter.process(sampleRate, v);
+            slewLimiter[lane].setRiseFall(s, s);
+            v = slewLimiter[lane].process(dt, v);
         }
 
         if (paramQuantity) {
@@ -482,13 +559,13 @@ struct ReMoveModule : MapModuleBase<1> {
         }
         switch (outCvMode) {
             case OUTCVMODE_CV_UNI:
-                outputs[CV_OUTPUT].setVoltage(rescale(v, 0.f, 1.f, 0.f, 10.f));
+                outputs[CV_OUTPUT].setVoltage(rescale(v, 0.f, 1.f, 0.f, 10.f), lane);
                 break;
             case OUTCVMODE_CV_BI:
-                outputs[CV_OUTPUT].setVoltage(rescale(v, 0.f, 1.f, -5.f, 5.f));
+                outputs[CV_OUTPUT].setVoltage(rescale(v, 0.f, 1.f, -5.f, 5.f), lane);
                 break;
             case OUTCVMODE_EOC:
-                if (dataPtr == seqLow + seqLength[seq] && playDir == REMOVE_PLAYDIR_FWD) {
+                if (dataPtr == storage->seqLength[seq] && playDir == REMOVE_PLAYDIR_FWD) {
                     switch (playMode) {
                         case PLAYMODE_LOOP:
                         case PLAYMODE_ONESHOT:
@@ -500,13 +577,122 @@ struct ReMoveModule : MapModuleBase<1> {
                             break;
                     }
                 }
-                if (dataPtr == seqLow - 1) {
+                if (dataPtr == -1) {
                     outCvPulse.trigger();
                 }
                 break;
         }
     }
 
+    /** Decimated sequences are never played as steps as they were verified only against linear and cubic interpolation */
+    inline INTERPOLATION getInterpolation() {
+        return interpolation == INTERPOLATION_NONE && storage->seqDecimation[seq] > 1 ? INTERPOLATION_LINEAR : interpolation;
+    }
+
+    /** Sets the values between two samples of playback, the phase is taken from sampleTimer */
+    inline void processInterpolation(INTERPOLATION interpolation, float sampleTime, float samplePeriod) {
+        float t = std::min(sampleTimer.time / samplePeriod, 1.f);
+        float *next = storage->frame(seq, dataPtr * lanes);
+        int nextPtr = clamp(dataPtr + playDir, 0, storage->seqLength[seq] - 1);
+        float *next2 = storage->frame(seq, nextPtr * lanes);
+        for (int i = 0; i < lanes; i++) {
+            float v = seqInterpolate(interpolation, playPrev[i], playFrom[i], next[i], next2[i], t);
+            setValue(i, v, getParamQuantity(i), sampleTime);
+        }
+    }
+
+    /**
+     * Finds the highest decimation of the current sequence whose linear and cubic interpolation
+     * stay within REMOVE_DECIMATION_TOLERANCE of the recording and drops the samples in between.
+     * The result does not depend on the interpolation selected at the time of recording. Each call
+     * handles REMOVE_DECIMATION_FRAMES frames so long takes don't cause dropouts, playback and
+     * recording resume when the pass has finished.
+     */
+    void processDecimation() {
+        int length = storage->seqLength[seq];
+        switch (decimateState) {
+            case DECIMATESTATE_LINEAR:
+            case DECIMATESTATE_CUBIC: {
+                int f = decimateFactor * 2;
+                int to = std::min(decimateFrame + REMOVE_DECIMATION_FRAMES, length);
+                INTERPOLATION interpolation = decimateState == DECIMATESTATE_LINEAR ? INTERPOLATION_LINEAR : INTERPOLATION_CUBIC;
+                if (!seqDecimationFits(f, interpolation, decimateFrame, to)) {
+                    decimateMove();
+                }
+                else if (to == length) {
+                    decimateFrame = 0;
+                    if (decimateState == DECIMATESTATE_LINEAR) {
+                        decimateState = DECIMATESTATE_CUBIC;
+                    }
+                    else {
+                        decimateFactor = f;
+                        decimateNext();
+                    }
+                }
+                else {
+                    decimateFrame = to;
+                }
+                break;
+            }
+            case DECIMATESTATE_MOVE: {
+                int d = decimateFactor;
+                int n = (length - 1) / d + 1;
+                int to = std::min(decimateFrame + REMOVE_DECIMATION_FRAMES, n);
+                // Frames move only towards the start, sources are never overwritten before they are read
+                for (int k = decimateFrame; k < to; k++) {
+                    float *frame = storage->frame(seq, k * d * lanes);
+                    std::copy(frame, frame + lanes, storage->frame(seq, k * lanes));
+                }
+                decimateFrame = to;
+                if (to == n) {
+                    storage->seqLength[seq] = n;
+                    storage->seqDecimation[seq] = d;
+                    decimateState = DECIMATESTATE_OFF;
+                    finishRecording();
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    /** Continues with the next higher decimation or with moving the frames if it is out of range */
+    void decimateNext() {
+        int f = decimateFactor * 2;
+        if (f <= REMOVE_MAX_DECIMATION && storage->seqLength[seq] / f >= 4) {
+            decimateState = DECIMATESTATE_LINEAR;
+            decimateFrame = 0;
+        }
+        else {
+            decimateMove();
+        }
+    }
+
+    void decimateMove() {
+        decimateState = DECIMATESTATE_MOVE;
+        // Frame 0 stays in place, nothing moves at all without decimation
+        decimateFrame = decimateFactor > 1 ? 1 : std::max(storage->seqLength[seq], 0);
+    }
+
+    /** Checks frames [from, to) of the current sequence against the interpolation of every f-th frame */
+    bool seqDecimationFits(int f, INTERPOLATION interpolation, int from, int to) {
+        int length = storage->seqLength[seq];
+        int last = (length - 1) / f;
+        for (int j = from; j < to; j++) {
+            int k = j / f;
+            float t = (float)(j % f) / f;
+            int k0 = std::max(k - 1, 0) * f;
+            int k2 = std::min(k + 1, last) * f;
+            int k3 = std::min(k + 2, last) * f;
+            for (int i = 0; i < lanes; i++) {
+                float v = seqInterpolate(interpolation, storage->get(seq, k0 * lanes + i), storage->get(seq, k * f * lanes + i), storage->get(seq, k2 * lanes + i), storage->get(seq, k3 * lanes + i), t);
+                if (std::abs(v - storage->get(seq, j * lanes + i)) > REMOVE_DECIMATION_TOLERANCE) return false;
+            }
+        }
+        return true;
+    }
+
     inline void processSetValue() {
         if (outCvMode == OUTCVMODE_EOC) {
             outputs[CV_OUTPUT].setVoltage(outCvPulse.process(engineSampleTime));
@@ -518,26 +704,49 @@ struct ReMoveModule : MapModuleBase<1> {
         recChangeHistory = new history::ModuleChange;
         recChangeHistory->name = "ReMOVE recording";
         recChangeHistory->moduleId = this->id;
+        jsonFromEngine = true;
         recChangeHistory->oldModuleJ = toJson();
+        jsonFromEngine = false;
 
-        seqLength[seq] = 0;
-        dataPtr = seqLow;
+        storage->seqLength[seq] = 0;
+        storage->seqDecimation[seq] = 1;
+        dataPtr = 0;
+        playFromValid = false;
         sampleTimer.reset();
-        if (!inputs[CV_INPUT].isConnected()) paramHandles[0].color = nvgRGB(0xff, 0x40, 0xff);
-        recTouch = getValue();
+        for (int i = 0; i < lanes; i++) {
+            if (!inputs[CV_INPUT].isConnected()) paramHandles[i].color = nvgRGB(0xff, 0x40, 0xff);
+            recTouch[i] = getValue(i);
+        }
         recTouched = false;
     }
 
     void stopRecording() {
         isRecording = false;
-        if (dataPtr != seqLow) recOutCvPulse.trigger();
-        dataPtr = seqLow;
+        if (dataPtr != 0) recOutCvPulse.trigger();
+        dataPtr = 0;
         sampleTimer.reset();
-        paramHandles[0].color = nvgRGB(0x40, 0xff, 0xff);
-        valueFilters[0].reset();
+        for (int i = 0; i < lanes; i++) {
+            paramHandles[i].color = nvgRGB(0x40, 0xff, 0xff);
+            valueFilters[i].reset();
+        }
+
+        if (recDecimate) {
+            // processDecimation() finishes the recording
+            decimateFactor = 1;
+            decimateNext();
+            return;
+        }
+        finishRecording();
+    }
+
+    void finishRecording() {
+        // Hand memory of a previous, longer recording back to the pool
+        storage->trim(seq, storage->seqLength[seq] * lanes);
 
         if (recChangeHistory) {
+            jsonFromEngine = true;
             recChangeHistory->newModuleJ = toJson();
+            jsonFromEngine = false;
             APP->history->push(recChangeHistory);
             recChangeHistory = NULL;
         }
@@ -551,7 +760,7 @@ struct ReMoveModule : MapModuleBase<1> {
         seq = (seq + 1) % seqCount;
         if (skipEmpty) {
             int i = 0;
-            while (i < seqCount && seqLength[seq] == 0) {
+            while (i < seqCount && storage->seqLength[seq] == 0) {
                 seq = (seq + 1) % seqCount;
                 i++;
             }
@@ -579,37 +788,101 @@ struct ReMoveModule : MapModuleBase<1> {
         if (isRecording) return;
         isPlaying = false;
         seq = 0;
-        seqCount = c;
+        storageReset(storageLatest()->lanes, c);
+    }
+
+    void setLanes(int l) {
+        if (isRecording) return;
+        for (int i = l; i < lanes; i++) {
+            clearMap(i);
+        }
+        mapLen = l;
+        storageReset(l, storageLatest()->seqCount);
+    }
+
+    /** Replaces all sequences by empty ones, called on the UI thread */
+    void storageReset(int lanes, int seqCount) {
+        ReMoveStorage *s = new ReMoveStorage;
+        s->setLanes(lanes);
+        s->seqCount = seqCount;
+        storageSubmit(s);
+    }
+
+    /** Hands a storage built on the UI thread over to process(), which swaps it in on the next sample */
+    void storageSubmit(ReMoveStorage *s) {
+        s->allocate = false;
+        s->fill(REMOVE_POOL_IDLE);
+        delete storageRetired.exchange(NULL);
+        delete storagePending.exchange(s);
+    }
+
+    /** Returns the storage loaded last, which might not be swapped in yet, UI thread only */
+    ReMoveStorage *storageLatest() {
+        ReMoveStorage *s = storagePending.load();
+        return s ? s : storageActive.load();
+    }
+
+    /** Swaps in the storage submitted by the UI thread once the previous one has been freed */
+    void storageSwap() {
+        if (storageRetired.load()) return;
+        ReMoveStorage *s = storagePending.exchange(NULL);
+        if (!s) return;
+        // A take still running ends in the storage it has been recorded to, finishing a pending
+        // decimation at once is acceptable as it only happens when loading right after a take
+        if (isRecording) stopRecording();
+        while (decimateState != DECIMATESTATE_OFF) processDecimation();
+        storageRetired.store(storage);
+        storage = s;
+        storageActive.store(s);
+        lanes = s->lanes;
+        seqCount = s->seqCount;
+        seq = clamp(seq, 0, seqCount - 1);
         dataPtr = 0;
-        for (int i = 0; i < REMOVE_MAX_SEQ; i++) seqLength[i] = 0;
+        playFromValid = false;
         seqUpdate();
     }
 
+    /** Frees the swapped out storage and keeps the pool of the active one filled, called on the UI thread */
+    void storageMaintain() {
+        delete storageRetired.exchange(NULL);
+        storageActive.load()->fill(isRecording ? REMOVE_POOL_RECORDING : REMOVE_POOL_IDLE);
+    }
+
     inline void seqUpdate() {
-        int s = REMOVE_MAX_DATA / seqCount;
-        seqLow = seq * s;
-        seqHigh =  (seq + 1) * s;
         switch (seqChangeMode) {
             case SEQCHANGEMODE_RESTART:
-                dataPtr = seqLow;
+                dataPtr = 0;
                 playDir = REMOVE_PLAYDIR_FWD;
                 sampleTimer.reset();
-                valueFilters[0].reset();
+                for (int i = 0; i < lanes; i++) {
+                    valueFilters[i].reset();
+                }
                 break;
             case SEQCHANGEMODE_OFFSET:
-                dataPtr = seqLength[seq] > 0 ? seqLow + (dataPtr % s) % seqLength[seq] : seqLow;
+                dataPtr = storage->seqLength[seq] > 0 ? std::max(dataPtr, 0) % storage->seqLength[seq] : 0;
                 break;
         }
     }
 
 
     void clearMap(int id) override {
-        onReset();
+        // The recording belongs to the parameter when only one is used
+        if (lanes == 1) onReset();
         MapModuleBase::clearMap(id);
     }
 
+    void updateMapLen() override {
+        mapLen = lanes;
+    }
+
+    void commitLearn() override {
+        MapModuleBase::commitLearn();
+        if (learningId >= lanes) learningId = -1;
+    }
+
     void enableLearn(int id) override {
         if (isRecording) return;
+        if (id >= lanes) return;
         MapModuleBase::enableLearn(id);
     }
 
@@ -619,37 +892,34 @@ struct ReMoveModule : MapModuleBase<1> {
 
         json_t *rec0J = json_object();
 
-        int s = REMOVE_MAX_DATA / seqCount;
-        json_t *seqDataJ = json_array();
+        // A storage loaded on the UI thread but not swapped in yet is the latest state
+        ReMoveStorage *storage = jsonFromEngine ? this->storage : storageLatest();
+        int lanes = storage->lanes;
+        int seqCount = storage->seqCount;
+
+        std::vector<uint8_t> seqDataBin;
+        seqDataBin.reserve(1024);
+        seqDataBin.push_back(REMOVE_DATA_VERSION);
         for (int i = 0; i < seqCount; i++) {
-            json_t *seqData1J = json_array();
-            float last1 = 100.f, last2 = -100.f;
-            for (int j = 0; j < seqLength[i]; j++) {
-                if (last1 == last2) {
-                    // 2 times same value -> compress!
-                    int c = 0;
-                    while (seqData[i * s + j] == last1 && j < seqLength[i]) { c++; j++; }
-                    json_array_append_new(seqData1J, json_integer(c));
-                    if (j < seqLength[i]) json_array_append_new(seqData1J, json_real(seqData[i * s + j]));
-                    last2 = -100.f;
-                    last1 = seqData[i * s + j];
-                } 
-                else {
-                    json_array_append_new(seqData1J, json_real(seqData[i * s + j]));
-                    last2 = last1;
-                    last1 = seqData[i * s + j];
-                }
+            for (int j = 0; j < lanes; j++) {
+                seqEncode(seqDataBin, *storage, i, storage->seqLength[i], lanes, j);
             }
-            json_array_append_new(seqDataJ, seqData1J);
         }
-        json_object_set_new(rec0J, "seqData", seqDataJ);
+        json_object_set_new(rec0J, "seqDataBin", json_string(string::toBase64(seqDataBin.data(), seqDataBin.size()).c_str()));
 
         json_t *seqLengthJ = json_array();
         for (int i = 0; i < seqCount; i++) {
-            json_array_append_new(seqLengthJ, json_integer(seqLength[i]));
+            json_array_append_new(seqLengthJ, json_integer(storage->seqLength[i]));
         }
         json_object_set_new(rec0J, "seqLength", seqLengthJ);
 
+        json_t *seqDecimationJ = json_array();
+        for (int i = 0; i < seqCount; i++) {
+            json_array_append_new(seqDecimationJ, json_integer(storage->seqDecimation[i]));
+        }
+        json_object_set_new(rec0J, "seqDecimation", seqDecimationJ);
+
+        json_object_set_new(rec0J, "lanes", json_integer(lanes));
         json_object_set_new(rec0J, "seqCount", json_integer(seqCount));
         json_object_set_new(rec0J, "seq", json_integer(seq));
         json_object_set_new(rec0J, "seqCvMode", json_integer(seqCvMode));
@@ -661,6 +931,8 @@ struct ReMoveModule : MapModuleBase<1> {
         json_object_set_new(rec0J, "recMode", json_integer(recMode));
         json_object_set_new(rec0J, "recAutoplay", json_boolean(recAutoplay));
         json_object_set_new(rec0J, "playMode", json_integer(playMode));
+        json_object_set_new(rec0J, "interpolation", json_integer(interpolation));
+        json_object_set_new(rec0J, "recDecimate", json_boolean(recDecimate));
         json_object_set_new(rec0J, "sampleRate", json_real(sampleRate));
         json_object_set_new(rec0J, "isPlaying", json_boolean(isPlaying));
 
@@ -678,10 +950,13 @@ struct ReMoveModule : MapModuleBase<1> {
         json_t *recJ = json_object_get(rootJ, "recorder");
         json_t *rec0J = json_array_get(recJ, 0);
 
+        // Build the sequences apart from the storage used by process()
+        ReMoveStorage *storage = new ReMoveStorage;
         json_t *seqCountJ = json_object_get(rec0J, "seqCount");
-        if (seqCountJ) seqCount = json_integer_value(seqCountJ);
+        storage->seqCount = seqCountJ ? clamp((int)json_integer_value(seqCountJ), 1, REMOVE_MAX_SEQ) : storageLatest()->seqCount;
+        int seqCount = storage->seqCount;
         json_t *seqJ = json_object_get(rec0J, "seq");
-        if (seqJ) seq = json_integer_value(seqJ);
+        if (seqJ) seq = clamp((int)json_integer_value(seqJ), 0, storage->seqCount - 1);
         json_t *seqCvModeJ = json_object_get(rec0J, "seqCvMode");
         if (seqCvModeJ) seqCvMode = (SEQCVMODE)json_integer_value(seqCvModeJ);
         json_t *seqChangeModeJ = json_object_get(rec0J, "seqChangeMode");
@@ -700,24 +975,72 @@ struct ReMoveModule : MapModuleBase<1> {
         if (recAutoplayJ) recAutoplay = json_boolean_value(recAutoplayJ);
         json_t *playModeJ = json_object_get(rec0J, "playMode");
         if (playModeJ) playMode = (PLAYMODE)json_integer_value(playModeJ);
+        json_t *interpolationJ = json_object_get(rec0J, "interpolation");
+        if (interpolationJ) interpolation = (INTERPOLATION)json_integer_value(interpolationJ);
+        json_t *recDecimateJ = json_object_get(rec0J, "recDecimate");
+        if (recDecimateJ) recDecimate = json_boolean_value(recDecimateJ);
         json_t *sampleRateJ = json_object_get(rec0J, "sampleRate");
         if (sampleRateJ) sampleRate = json_real_value(sampleRateJ);
         json_t *isPlayingJ = json_object_get(rec0J, "isPlaying");
         if (isPlayingJ) isPlaying = json_boolean_value(isPlayingJ);
 
+        // Patches of version 1.5.0 and earlier contain only one lane
+        json_t *lanesJ = json_object_get(rec0J, "lanes");
+        int lanes = 1;
+        if (lanesJ) {
+            // Only powers of two are valid, frames would cross chunk boundaries otherwise
+            int l = clamp((int)json_integer_value(lanesJ), 1, REMOVE_MAX_LANES);
+            while (lanes * 2 <= l) lanes *= 2;
+        }
+        storage->setLanes(lanes);
+        mapLen = lanes;
+
         json_t *seqLengthJ = json_object_get(rec0J, "seqLength");
         if (seqLengthJ) {
             json_t *d;
             size_t i;
             json_array_foreach(seqLengthJ, i, d) {
                 if ((int)i >= seqCount) continue;
-                seqLength[i] = json_integer_value(d);
+                storage->seqLength[i] = json_integer_value(d);
+            }
+        }
+
+        json_t *seqDecimationJ = json_object_get(rec0J, "seqDecimation");
+        if (seqDecimationJ) {
+            json_t *d;
+            size_t i;
+            json_array_foreach(seqDecimationJ, i, d) {
+                if ((int)i >= seqCount) continue;
+                storage->seqDecimation[i] = clamp((int)json_integer_value(d), 1, REMOVE_MAX_DECIMATION);
             }
         }
 
-        int s = REMOVE_MAX_DATA / seqCount;
+        json_t *seqDataBinJ = json_object_get(rec0J, "seqDataBin");
         json_t *seqDataJ = json_object_get(rec0J, "seqData");
-        if (seqDataJ) {
+        if (seqDataBinJ && json_string_value(seqDataBinJ)) {
+            size_t len = 0;
+            uint8_t *buffer = string::fromBase64(json_string_value(seqDataBinJ), &len);
+            if (buffer && len > 0 && buffer[0] == REMOVE_DATA_VERSION) {
+                const uint8_t *p = buffer + 1;
+                const uint8_t *end = buffer + len;
+                for (int i = 0; i < seqCount; i++) {
+                    int l = REMOVE_MAX_DATA;
+                    for (int j = 0; j < lanes && l >= 0; j++) {
+                        int n = seqDecode(p, end, *storage, i, lanes, j);
+                        l = n < 0 ? n : std::min(l, n);
+                    }
+                    if (l < 0) {
+                        WARN("ReMOVE: malformed recording data");
+                        for (; i < seqCount; i++) storage->seqLength[i] = 0;
+                        break;
+                    }
+                    storage->seqLength[i] = l;
+                }
+            }
+            delete[] buffer;
+        }
+        else if (seqDataJ) {
+            // Patches of version 1.5.0 and earlier store the data as array with run-length pairs
             json_t *seqData1J, *d;
             size_t i;
             json_array_foreach(seqDataJ, i, seqData1J) {
@@ -726,26 +1049,27 @@ struct ReMoveModule : MapModuleBase<1> {
                 float last1 = 100.f, last2 = -100.f;
                 int c = 0;
                 json_array_foreach(seqData1J, j, d) {
-                    if (c > seqLength[i]) continue;
+                    if (c > storage->seqLength[i]) continue;
                     if (last1 == last2) {
                         // we've seen two same values -> decompress!
                         int v = json_integer_value(d);
-                        for (int k = 0; k < v; k++) { seqData[i * s + c] = last1; c++; }
+                        for (int k = 0; k < v && storage->reserve(i, c); k++) { storage->set(i, c, last1); c++; }
                         last1 = 100.f; last2 = -100.f;
                     }
-                    else {
-                        seqData[i * s + c] = json_real_value(d);
+                    else if (storage->reserve(i, c)) {
+                        storage->set(i, c, json_real_value(d));
                         last2 = last1;
-                        last1 = seqData[i * s + c];
+                        last1 = storage->get(i, c);
                         c++;
                     }
                 }
+                storage->seqLength[i] = std::min(storage->seqLength[i], c);
             }
         }
 
         isRecording = false;
         params[REC_PARAM].setValue(0);
-        seqUpdate();
+        storageSubmit(storage);
     }
 
     void onRandomize() override {
@@ -755,27 +1079,37 @@ struct ReMoveModule : MapModuleBase<1> {
         dsp::ExponentialFilter filter;
         filter.setLambda(sampleRate * 10.f);
 
-        int s = REMOVE_MAX_DATA / seqCount;
-        // Generate maximum of 4 seconds random data
-        int l = std::min((int)round(1.f / sampleRate * 8.f), s);
+        ReMoveStorage *storage = new ReMoveStorage;
+        storage->setLanes(storageLatest()->lanes);
+        storage->seqCount = storageLatest()->seqCount;
+        int lanes = storage->lanes;
+        int seqCount = storage->seqCount;
+
+        // Generate maximum of 4 seconds random data, all sequences must fit into the storage
+        int l = std::min((int)round(1.f / sampleRate * 8.f), REMOVE_MAX_DATA / seqCount);
 
         for (int i = 0; i < seqCount; i++) {
-            // Set some start-value for the exponential filter
-            filter.out = 0.5f + d(gen) * 10.f;
-            float dir = 1.f;
-            float p = 0.5f;
-            for (int c = 0; c < l; c++) {
-                // Reduce the number of direction changes, only when rand > 0
-                if (c % (l / 8) == 0) dir = d(gen) >= 0 ? 1 : -1;
-                float r = d(gen);
-                // Inject some static in the curve
-                p = filter.process(1.f, r >= 0.005f ? p + dir * abs(r) : p);
-                // Only range [0,1] is valid
-                p = clamp(p, 0.f, 1.f);
-                seqData[i * s + c] = p;
+            for (int j = 0; j < lanes; j++) {
+                // Set some start-value for the exponential filter
+                filter.out = 0.5f + d(gen) * 10.f;
+                float dir = 1.f;
+                float p = 0.5f;
+                for (int c = 0; c < l; c++) {
+                    // Reduce the number of direction changes, only when rand > 0
+                    if (c % (l / 8) == 0) dir = d(gen) >= 0 ? 1 : -1;
+                    float r = d(gen);
+                    // Inject some static in the curve
+                    p = filter.process(1.f, r >= 0.005f ? p + dir * abs(r) : p);
+                    // Only range [0,1] is valid
+                    p = clamp(p, 0.f, 1.f);
+                    storage->reserve(i, c * lanes + j);
+                    storage->set(i, c * lanes + j, p);
+                }
             }
-            seqLength[i] = l;
+            storage->seqLength[i] = l;
+            storage->seqDecimation[i] = 1;
         }
+        storageSubmit(storage);
     }
 };
 
@@ -801,11 +1135,12 @@ struct ReMoveDisplay : TransparentWidget {
         nvgClosePath(vg);
         nvgStroke(vg);
 
-        int seqPos = module->dataPtr - module->seqLow;
+        ReMoveStorage *storage = module->storageActive.load();
+        int seqPos = module->dataPtr;
 
         if (module->isRecording) {
             // Draw text showing remaining time
-            float t = ((float)REMOVE_MAX_DATA / (float)module->seqCount - (float)seqPos) * module->sampleRate;
+            float t = (float)(storage->available(module->seq, seqPos * storage->lanes) / storage->lanes) * module->sampleRate;
             nvgFontSize(vg, 11);
             nvgFontFaceId(vg, font->handle);
             nvgTextLetterSpacing(vg, -2.2);
@@ -813,7 +1148,7 @@ struct ReMoveDisplay : TransparentWidget {
             nvgTextBox(vg, 6, box.size.y - 4, 120, string::f("REC -%.1fs", t).c_str(), NULL);
         }
 
-        int seqLength = module->seqLength[module->seq];
+        int seqLength = storage->seqLength[module->seq];
         if (seqLength < 2) return;
 
         if (!module->isRecording && seqLength > 2) {
@@ -827,22 +1162,25 @@ struct ReMoveDisplay : TransparentWidget {
             nvgStroke(vg);
         }
 
-        // Draw automation-line
+        // Draw automation-line of each lane
         nvgStrokeColor(vg, nvgRGB(0xd8, 0xd8, 0xd8));
         nvgSave(vg);
         Rect b = Rect(Vec(0, 2), Vec(maxX, maxY - 4));
         nvgScissor(vg, b.pos.x, b.pos.y, b.size.x, b.size.y);
         nvgBeginPath(vg);
         int c = std::min(seqLength, 120);
-        for (int i = 0; i < c; i++) {
-            float x = (float)i / (c - 1);
-            float y = module->seqData[module->seqLow + (int)floor(x * (seqLength - 1))] * 0.96f + 0.02f;
-            float px = b.pos.x + b.size.x * x;
-            float py = b.pos.y + b.size.y * (1.0 - y);
-            if (i == 0)
-                nvgMoveTo(vg, px, py);
-            else
-                nvgLineTo(vg, px, py);
+        int lanes = storage->lanes;
+        for (int j = 0; j < lanes; j++) {
+            for (int i = 0; i < c; i++) {
+                float x = (float)i / (c - 1);
+                float y = storage->peek(module->seq, (int)floor(x * (seqLength - 1)) * lanes + j) * 0.96f + 0.02f;
+                float px = b.pos.x + b.size.x * x;
+                float py = b.pos.y + b.size.y * (1.0 - y);
+                if (i == 0)
+                    nvgMoveTo(vg, px, py);
+                else
+                    nvgLineTo(vg, px, py);
+            }
         }
 
         nvgLineCap(vg, NVG_ROUND);
@@ -857,6 +1195,26 @@ struct ReMoveDisplay : TransparentWidget {
 
 
 
+struct ReMoveMapChoice : MapModuleChoice<REMOVE_MAX_LANES, ReMoveModule> {
+    std::string getSlotPrefix() override {
+        return module->lanes > 1 ? string::f("%d ", id + 1) : "";
+    }
+};
+
+struct ReMoveMapDisplay : MapModuleDisplay<REMOVE_MAX_LANES, ReMoveModule, ReMoveMapChoice> {
+    void step() override {
+        if (module) {
+            // Show only the slots of the used lanes
+            for (int id = 0; id < REMOVE_MAX_LANES; id++) {
+                choices[id]->visible = id < module->lanes;
+                separators[id]->visible = id < module->lanes;
+            }
+        }
+        MapModuleDisplay<REMOVE_MAX_LANES, ReMoveModule, ReMoveMapChoice>::step();
+    }
+};
+
+
 struct SeqCvModeMenuItem : MenuItem {
     struct SeqCvModeItem : MenuItem {
         ReMoveModule *module;
@@ -987,8 +1345,7 @@ struct SampleRateMenuItem : MenuItem {
 
         void step() override {
             int s1 = REMOVE_MAX_DATA * sampleRate;
-            int s2 = s1 / module->seqCount;
-            rightText = string::f(((module->sampleRate == sampleRate) ? "✔ %ds / %ds" : "%ds / %ds"), s1, s2);
+            rightText = string::f(((module->sampleRate == sampleRate) ? "✔ %ds" : "%ds"), s1);
             MenuItem::step();
         }
     };
@@ -1037,6 +1394,34 @@ struct SeqCountMenuItem : MenuItem {
 };
 
 
+struct LanesMenuItem : MenuItem {
+    struct LanesItem : MenuItem {
+        ReMoveModule *module;
+        int lanes;
+
+        void onAction(const event::Action &e) override {
+            if (module->isRecording) return;
+            module->setLanes(lanes);
+        }
+
+        void step() override {
+            rightText = (module->lanes == lanes) ? "✔" : "";
+            MenuItem::step();
+        }
+    };
+    
+    ReMoveModule *module;
+    Menu *createChildMenu() override {
+        Menu *menu = new Menu;
+        std::vector<std::string> names = {"1", "2", "4", "8"};
+        for (size_t i = 0; i < names.size(); i++) {
+            menu->addChild(construct<LanesItem>(&MenuItem::text, names[i], &LanesItem::module, module, &LanesItem::lanes, (int)pow(2, i)));
+        }
+        return menu;
+    }
+};
+
+
 struct SeqChangeModeMenuItem : MenuItem {
     struct SeqChangeModeItem : MenuItem {
         ReMoveModule *module;
@@ -1102,6 +1487,44 @@ struct RecAutoplayItem : MenuItem {
     }
 };
 
+struct RecDecimateItem : MenuItem {
+    ReMoveModule *module;
+
+    void onAction(const event::Action &e) override {
+        module->recDecimate ^= true;
+    }
+
+    void step() override {
+        rightText = module->recDecimate ? "✔" : "";
+        MenuItem::step();
+    }
+};
+
+struct InterpolationMenuItem : MenuItem {
+    struct InterpolationItem : MenuItem {
+        ReMoveModule *module;
+        INTERPOLATION interpolation;
+
+        void onAction(const event::Action &e) override {
+            module->interpolation = interpolation;
+        }
+
+        void step() override {
+            rightText = (module->interpolation == interpolation) ? "✔" : "";
+            MenuItem::step();
+        }
+    };
+    
+    ReMoveModule *module;
+    Menu *createChildMenu() override {
+        Menu *menu = new Menu;
+        menu->addChild(construct<InterpolationItem>(&MenuItem::text, "None", &InterpolationItem::module, module, &InterpolationItem::interpolation, INTERPOLATION_NONE));
+        menu->addChild(construct<InterpolationItem>(&MenuItem::text, "Linear", &InterpolationItem::module, module, &InterpolationItem::interpolation, INTERPOLATION_LINEAR));
+        menu->addChild(construct<InterpolationItem>(&MenuItem::text, "Cubic", &InterpolationItem::module, module, &InterpolationItem::interpolation, INTERPOLATION_CUBIC));
+        return menu;
+    }
+};
+
 struct PlayModeMenuItem : MenuItem {
     struct PlayModeItem : MenuItem {
         ReMoveModule *module;
@@ -1187,6 +1610,8 @@ struct RecLight : RedLight {
 
 
 struct ReMoveWidget : ThemedModuleWidget<ReMoveModule> {
+    Widget *draggedWidget = NULL;
+
     ReMoveWidget(ReMoveModule *module)
         : ThemedModuleWidget<ReMoveModule>(module, "ReMove") {
         setModule(module);
@@ -1226,7 +1651,7 @@ struct ReMoveWidget : ThemedModuleWidget<ReMoveModule> {
         addParam(createParamCentered<StoermelderTrimpot>(Vec(45.0f, 187.2f), module, ReMoveModule::SLEW_PARAM));
         addInput(createInputCentered<StoermelderPort>(Vec(68.7f, 200.1f), module, ReMoveModule::PHASE_INPUT));
 
-        MapModuleDisplay<1, ReMoveModule> *mapWidget = createWidget<MapModuleDisplay<1, ReMoveModule>>(Vec(6.8f, 36.4f));
+        ReMoveMapDisplay *mapWidget = createWidget<ReMoveMapDisplay>(Vec(6.8f, 36.4f));
         mapWidget->box.size = Vec(76.2f, 23.f);
         mapWidget->setModule(module);
         addChild(mapWidget);
@@ -1238,6 +1663,23 @@ struct ReMoveWidget : ThemedModuleWidget<ReMoveModule> {
         addChild(display); 
     }
 
+    void step() override {
+        if (module) module->storageMaintain();
+        // Observe the dragged widget on the UI thread, the module only reads the published state
+        Widget *w = APP->event->getDraggedWidget();
+        if (module && w != draggedWidget) {
+            draggedWidget = w;
+            TOUCHSTATE touchState = TOUCHSTATE_NONE;
+            if (w) {
+                ParamWidget *pw = dynamic_cast<ParamWidget*>(w);
+                bool isLane = pw && pw->paramQuantity && pw->paramQuantity->module && module->isLane(pw->paramQuantity->module->id, pw->paramQuantity->paramId);
+                touchState = isLane ? TOUCHSTATE_PARAM : TOUCHSTATE_OTHER;
+            }
+            module->touchState = touchState;
+        }
+        ThemedModuleWidget<ReMoveModule>::step();
+    }
+
     void appendContextMenu(Menu *menu) override {
         ThemedModuleWidget<ReMoveModule>::appendContextMenu(menu);
         ReMoveModule *module = dynamic_cast<ReMoveModule*>(this->module);
@@ -1253,6 +1695,10 @@ struct ReMoveWidget : ThemedModuleWidget<ReMoveModule> {
         seqCountMenuItem->rightText = RIGHT_ARROW;
         menu->addChild(seqCountMenuItem);
 
+        LanesMenuItem *lanesMenuItem = construct<LanesMenuItem>(&MenuItem::text, "# of parameters", &LanesMenuItem::module, module);
+        lanesMenuItem->rightText = RIGHT_ARROW;
+        menu->addChild(lanesMenuItem);
+
         SeqChangeModeMenuItem *seqChangeModeMenuItem = construct<SeqChangeModeMenuItem>(&MenuItem::text, "Sequence change mode", &SeqChangeModeMenuItem::module, module);
         seqChangeModeMenuItem->rightText = RIGHT_ARROW;
         menu->addChild(seqChangeModeMenuItem);
@@ -1265,10 +1711,17 @@ struct ReMoveWidget : ThemedModuleWidget<ReMoveModule> {
         recAutoplayItem->rightText = RIGHT_ARROW;
         menu->addChild(recAutoplayItem);
 
+        RecDecimateItem *recDecimateItem = construct<RecDecimateItem>(&MenuItem::text, "Decimate after record", &RecDecimateItem::module, module);
+        menu->addChild(recDecimateItem);
+
         PlayModeMenuItem *playModeMenuItem = construct<PlayModeMenuItem>(&MenuItem::text, "Play mode", &PlayModeMenuItem::module, module);
         playModeMenuItem->rightText = RIGHT_ARROW;
         menu->addChild(playModeMenuItem);
 
+        InterpolationMenuItem *interpolationMenuItem = construct<InterpolationMenuItem>(&MenuItem::text, "Interpolation", &InterpolationMenuItem::module, module);
+        interpolationMenuItem->rightText = RIGHT_ARROW;
+        menu->addChild(interpolationMenuItem);
+
         menu->addChild(new MenuSeparator());
 
         SeqCvModeMenuItem *seqCvModeMenuItem = construct<SeqCvModeMenuItem>(&MenuItem::text, "Port SEQ# mode", &SeqCvModeMenuItem::module, module);
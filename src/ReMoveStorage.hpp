@@ -0,0 +1,285 @@
+#pragma once
+#include "rack.hpp"
+#include <vector>
+#include <cassert>
+#include <atomic>
+
+
+namespace ReMove {
+
+const int REMOVE_MAX_DATA = 64 * 1024;
+const int REMOVE_MAX_SEQ = 8;
+const int REMOVE_MAX_LANES = 8;
+const int REMOVE_MAX_DECIMATION = 8;
+const float REMOVE_DECIMATION_TOLERANCE = 1.f / 1024.f;
+/** frames verified or moved per call of process() while decimating */
+const int REMOVE_DECIMATION_FRAMES = 64;
+const int REMOVE_CHUNK_BITS = 12;
+const int REMOVE_CHUNK_SIZE = 1 << REMOVE_CHUNK_BITS;
+const int REMOVE_MAX_CHUNKS = REMOVE_MAX_DATA / REMOVE_CHUNK_SIZE;
+
+enum INTERPOLATION {
+    INTERPOLATION_NONE = 0,
+    INTERPOLATION_LINEAR = 1,
+    INTERPOLATION_CUBIC = 2
+};
+
+const int REMOVE_POOL_SIZE = REMOVE_MAX_CHUNKS * REMOVE_MAX_LANES;
+/** spare chunks kept for the first samples of a recording */
+const int REMOVE_POOL_IDLE = 1;
+/** spare chunks kept while recording, enough for a second at 2000Hz with 8 lanes */
+const int REMOVE_POOL_RECORDING = 4;
+
+/**
+ * Sample memory of all sequences. Memory is allocated in chunks of REMOVE_CHUNK_SIZE samples
+ * while recording, so a module without any recordings uses almost no sample memory. All
+ * sequences share a budget of REMOVE_MAX_DATA samples per lane, the length of each sequence is
+ * independent of the others. Lanes are interleaved, so the samples of one frame are adjacent
+ * and never cross a chunk boundary.
+ *
+ * A storage used by process() never allocates or frees memory itself: reserve() takes chunks
+ * from a pool which is filled by fill() on the UI thread, trim() hands chunks back to the pool
+ * and fill() frees the ones exceeding the spare count. The UI thread may read samples while the
+ * engine thread trims, chunks stay valid until the next fill() and missing chunks read as 0.
+ */
+struct ReMoveStorage {
+    std::atomic<float*> chunks[REMOVE_MAX_SEQ][REMOVE_POOL_SIZE];
+    std::atomic<float*> pool[REMOVE_POOL_SIZE];
+    /** number of chunks of all sequences, excluding the pool */
+    std::atomic<int> chunkCount{0};
+    /** maximum number of chunks of all sequences */
+    int chunkLimit = REMOVE_MAX_CHUNKS;
+    /** allocates chunks if the pool is empty, only for storages not used by process() */
+    bool allocate = true;
+
+    /** [Stored to JSON] */
+    int lanes = 1;
+    /** [Stored to JSON] */
+    int seqCount = 4;
+    /** [Stored to JSON] */
+    int seqLength[REMOVE_MAX_SEQ] = {};
+    /** [Stored to JSON] */
+    int seqDecimation[REMOVE_MAX_SEQ];
+
+    static_assert(REMOVE_CHUNK_SIZE % REMOVE_MAX_LANES == 0, "frames must not cross chunk boundaries");
+
+    ReMoveStorage() {
+        for (int i = 0; i < REMOVE_MAX_SEQ; i++) {
+            for (int c = 0; c < REMOVE_POOL_SIZE; c++) chunks[i][c].store(NULL);
+            seqDecimation[i] = 1;
+        }
+        for (int c = 0; c < REMOVE_POOL_SIZE; c++) pool[c].store(NULL);
+    }
+
+    ~ReMoveStorage() {
+        for (int i = 0; i < REMOVE_MAX_SEQ; i++) {
+            for (int c = 0; c < REMOVE_POOL_SIZE; c++) delete[] chunks[i][c].load();
+        }
+        for (int c = 0; c < REMOVE_POOL_SIZE; c++) delete[] pool[c].load();
+    }
+
+    /** Sets the budget for the number of lanes, frames stay within a chunk only for powers of two */
+    void setLanes(int lanes) {
+        assert(lanes > 0 && REMOVE_CHUNK_SIZE % lanes == 0);
+        this->lanes = lanes;
+        chunkLimit = REMOVE_MAX_CHUNKS * lanes;
+    }
+
+    inline float get(int seq, int i) {
+        return chunks[seq][i >> REMOVE_CHUNK_BITS].load(std::memory_order_relaxed)[i & (REMOVE_CHUNK_SIZE - 1)];
+    }
+
+    inline void set(int seq, int i, float v) {
+        chunks[seq][i >> REMOVE_CHUNK_BITS].load(std::memory_order_relaxed)[i & (REMOVE_CHUNK_SIZE - 1)] = v;
+    }
+
+    inline float *frame(int seq, int i) {
+        return &chunks[seq][i >> REMOVE_CHUNK_BITS].load(std::memory_order_relaxed)[i & (REMOVE_CHUNK_SIZE - 1)];
+    }
+
+    /** Like get() but for the UI thread, returns 0 for samples trimmed meanwhile */
+    inline float peek(int seq, int i) {
+        if (i >> REMOVE_CHUNK_BITS >= REMOVE_POOL_SIZE) return 0.f;
+        float* c = chunks[seq][i >> REMOVE_CHUNK_BITS].load(std::memory_order_acquire);
+        return c ? c[i & (REMOVE_CHUNK_SIZE - 1)] : 0.f;
+    }
+
+    /** Makes sure sample i of a sequence is backed by memory, returns false if the budget is used up
+     * or the pool ran dry */
+    bool reserve(int seq, int i) {
+        int c = i >> REMOVE_CHUNK_BITS;
+        if (c >= REMOVE_POOL_SIZE) return false;
+        if (chunks[seq][c].load(std::memory_order_relaxed)) return true;
+        if (chunkCount >= chunkLimit) return false;
+        float* chunk = poolTake();
+        if (!chunk && allocate) chunk = new float[REMOVE_CHUNK_SIZE];
+        if (!chunk) return false;
+        chunks[seq][c].store(chunk, std::memory_order_release);
+        chunkCount++;
+        return true;
+    }
+
+    /** Hands all chunks of a sequence which are not needed for storing length samples back to the pool */
+    void trim(int seq, int length) {
+        for (int c = (length + REMOVE_CHUNK_SIZE - 1) >> REMOVE_CHUNK_BITS; c < REMOVE_POOL_SIZE; c++) {
+            float* chunk = chunks[seq][c].exchange(NULL);
+            if (!chunk) break;
+            poolGive(chunk);
+            chunkCount--;
+        }
+    }
+
+    void clear(int seq) {
+        trim(seq, 0);
+    }
+
+    /** Returns the number of samples which can be appended to a sequence of given length */
+    int available(int seq, int length) {
+        int c = 0;
+        while (c < REMOVE_POOL_SIZE && chunks[seq][c].load(std::memory_order_relaxed)) c++;
+        return (c + chunkLimit - chunkCount) * REMOVE_CHUNK_SIZE - length;
+    }
+
+    /** Allocates or frees chunks of the pool until it holds spare chunks, must not be called from process() */
+    void fill(int spare) {
+        int n = 0;
+        for (int c = 0; c < REMOVE_POOL_SIZE; c++) {
+            if (!pool[c].load()) continue;
+            if (n < spare) {
+                n++;
+                continue;
+            }
+            delete[] pool[c].exchange(NULL);
+        }
+        // Chunks of the sequences and the pool never exceed the size of the pool, so trim()
+        // always finds an empty slot
+        spare = std::min(spare, REMOVE_POOL_SIZE - chunkCount);
+        for (int c = 0; c < REMOVE_POOL_SIZE && n < spare; c++) {
+            if (pool[c].load()) continue;
+            float* chunk = new float[REMOVE_CHUNK_SIZE];
+            float* expected = NULL;
+            if (pool[c].compare_exchange_strong(expected, chunk)) n++;
+            else delete[] chunk;
+        }
+    }
+
+    float* poolTake() {
+        for (int c = 0; c < REMOVE_POOL_SIZE; c++) {
+            if (!pool[c].load(std::memory_order_relaxed)) continue;
+            float* chunk = pool[c].exchange(NULL);
+            if (chunk) return chunk;
+        }
+        return NULL;
+    }
+
+    void poolGive(float* chunk) {
+        for (int c = 0; c < REMOVE_POOL_SIZE; c++) {
+            float* expected = NULL;
+            if (pool[c].compare_exchange_strong(expected, chunk)) return;
+        }
+        assert(false);
+    }
+};
+
+
+/** version of the binary format of "seqDataBin" */
+const uint8_t REMOVE_DATA_VERSION = 1;
+
+
+// Recorded values are in the range [0,1] and get quantized to 16 bit. Each sample is written
+// as zigzag-encoded delta to its predecessor in a LEB128-style varint. A zero delta is followed
+// by the number of repetitions, so held values take only two bytes. Lanes are encoded one
+// after another as deltas between adjacent lanes are meaningless.
+
+inline void seqEncodeVarint(std::vector<uint8_t>& buffer, uint32_t v) {
+    while (v >= 0x80) {
+        buffer.push_back((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    buffer.push_back(v);
+}
+
+inline bool seqDecodeVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 32; shift += 7) {
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+inline int32_t seqQuantize(float v) {
+    return (int32_t)std::round(rack::math::clamp(v, 0.f, 1.f) * 65535.f);
+}
+
+inline void seqEncode(std::vector<uint8_t>& buffer, ReMoveStorage& storage, int seq, int length, int lanes, int lane) {
+    seqEncodeVarint(buffer, length);
+    int32_t last = 0;
+    int i = 0;
+    while (i < length) {
+        int32_t q = seqQuantize(storage.peek(seq, i * lanes + lane));
+        int32_t d = q - last;
+        seqEncodeVarint(buffer, ((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+        i++;
+        if (d == 0) {
+            uint32_t c = 1;
+            while (i < length && seqQuantize(storage.peek(seq, i * lanes + lane)) == q) { c++; i++; }
+            seqEncodeVarint(buffer, c);
+        }
+        last = q;
+    }
+}
+
+/**
+ * Decodes one lane of a sequence into the storage, returns the number of stored samples or -1
+ * on malformed input. Samples exceeding the storage's budget are skipped.
+ */
+inline int seqDecode(const uint8_t*& p, const uint8_t* end, ReMoveStorage& storage, int seq, int lanes, int lane) {
+    uint32_t length;
+    if (!seqDecodeVarint(p, end, length)) return -1;
+    if (length > (uint32_t)REMOVE_MAX_DATA) return -1;
+    int n = 0;
+    bool full = false;
+    int32_t last = 0;
+    uint32_t i = 0;
+    while (i < length) {
+        uint32_t z;
+        if (!seqDecodeVarint(p, end, z)) return -1;
+        int32_t d = (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+        last += d;
+        if (last < 0 || last > 65535) return -1;
+        float v = last / 65535.f;
+        uint32_t c = 1;
+        if (d == 0 && !seqDecodeVarint(p, end, c)) return -1;
+        if (c == 0 || c > length - i) return -1;
+        for (uint32_t k = 0; k < c && !full; k++) {
+            if (!storage.reserve(seq, (i + k) * lanes + lane)) { full = true; break; }
+            storage.set(seq, (i + k) * lanes + lane, v);
+            n = i + k + 1;
+        }
+        i += c;
+    }
+    return n;
+}
+
+
+/** Interpolates between y1 and y2 by t in [0,1] */
+inline float seqInterpolate(INTERPOLATION interpolation, float y0, float y1, float y2, float y3, float t) {
+    switch (interpolation) {
+        default:
+        case INTERPOLATION_NONE:
+            return y1;
+        case INTERPOLATION_LINEAR:
+            return rack::math::crossfade(y1, y2, t);
+        case INTERPOLATION_CUBIC: {
+            // Catmull-Rom spline, may overshoot the range [0,1]
+            float a = -0.5f * y0 + 1.5f * y1 - 1.5f * y2 + 0.5f * y3;
+            float b = y0 - 2.5f * y1 + 2.f * y2 - 0.5f * y3;
+            float c = -0.5f * y0 + 0.5f * y2;
+            return rack::math::clamp(((a * t + b) * t + c) * t + y1, 0.f, 1.f);
+        }
+    }
+}
+
+} // namespace ReMove
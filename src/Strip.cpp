@@ -3,6 +3,7 @@
 #include <plugin.hpp>
 #include <thread>
 #include <mutex>
+#include <atomic>
 
 
 namespace Strip {
@@ -61,6 +62,11 @@ struct StripModule : Module {
 	ONMODE onMode = ONMODE_DEFAULT;
 
 	bool lastState = false;
+	/** Set if bypassing could not be queued completely, retried on the next sample */
+	bool bypassPending = false;
+	/** Set by the engine-thread, randomization is done on the app-thread */
+	std::atomic<bool> randomizeRequested{false};
+	std::atomic<bool> randomizeUseHistory{false};
 
 	std::mutex excludeMutex;
 	bool excludeLearn = false;
@@ -102,6 +108,9 @@ struct StripModule : Module {
 			lastState = true;
 		}
 
+		if (bypassPending)
+			bypassPending = !groupBypass(lastState);
+
 		if (offPTrigger.process(params[OFF_PARAM].getValue() + inputs[OFF_INPUT].getVoltage())) {
 			groupDisable(true, params[OFF_PARAM].getValue() > 0.f);
 		}
@@ -121,7 +130,9 @@ struct StripModule : Module {
 		}
 
 		if (randTrigger.process(params[RAND_PARAM].getValue() + inputs[RAND_INPUT].getVoltage())) {
-			groupRandomize(params[RAND_PARAM].getValue() > 0.f);
+			// Randomization accesses widgets, so it is deferred to StripWidget::step()
+			randomizeUseHistory = params[RAND_PARAM].getValue() > 0.f;
+			randomizeRequested = true;
 		}
 
 		// Set channel lights infrequently
@@ -136,11 +147,12 @@ struct StripModule : Module {
 
 	/** 
 	 * Disables/enables all modules of the current strip.
-	 * To be called from engine-thread only.
+	 * To be called from engine-thread only, bypass changes are applied by the EngineQueue.
 	 */
 	void groupDisable(bool val, bool useHistory) {
 		if (lastState == val) return;
 		lastState = val;
+		bypassPending = false;
 
 		history::ComplexAction* complexAction;
 		if (useHistory) {
@@ -153,20 +165,15 @@ struct StripModule : Module {
 			Module* m = this;
 			while (true) {
 				if (!m || m->rightExpander.moduleId < 0) break;
-				// This is what "Module.hpp" says about bypass:
-				// "Module subclasses should not read/write this variable."
-				m->rightExpander.module->bypass = val;
-				// Clear outputs and set to 1 channel
-				for (Output& output : m->rightExpander.module->outputs) {
-					// This zeros all voltages, but the channel is set to 1 if connected
-					output.setChannels(0);
-				}
+				// Don't write Module::bypass from here, Engine::bypassModule also clears the outputs.
+				if (!engineQueue.pushModuleBypass(m->rightExpander.moduleId, val))
+					bypassPending = true;
 
 				if (useHistory) {
 					// history::ModuleBypass
 					history::ModuleBypass* h = new history::ModuleBypass;
 					h->moduleId = m->rightExpander.module->id;
-					h->bypass = m->rightExpander.module->bypass;
+					h->bypass = val;
 					complexAction->push(h);
 				}
 
@@ -178,20 +185,15 @@ struct StripModule : Module {
 			Module* m = this;
 			while (true) {
 				if (!m || m->leftExpander.moduleId < 0) break;
-				// This is what "Module.hpp" says about bypass:
-				// "Module subclasses should not read/write this variable."
-				m->leftExpander.module->bypass = val;
-				// Clear outputs and set to 1 channel
-				for (Output& output : m->leftExpander.module->outputs) {
-					// This zeros all voltages, but the channel is set to 1 if connected
-					output.setChannels(0);
-				}
+				// Don't write Module::bypass from here, Engine::bypassModule also clears the outputs.
+				if (!engineQueue.pushModuleBypass(m->leftExpander.moduleId, val))
+					bypassPending = true;
 
 				if (useHistory) {
 					// history::ModuleBypass
 					history::ModuleBypass* h = new history::ModuleBypass;
 					h->moduleId = m->leftExpander.module->id;
-					h->bypass = m->leftExpander.module->bypass;
+					h->bypass = val;
 					complexAction->push(h);
 				}
 
@@ -200,9 +202,26 @@ struct StripModule : Module {
 		}
 	}
 
+	/**
+	 * Queues bypassing of all modules of the current strip again, without history.
+	 * Returns false if the EngineQueue is still full.
+	 */
+	bool groupBypass(bool val) {
+		bool queued = true;
+		if (mode == MODE_LEFTRIGHT || mode == MODE_RIGHT) {
+			for (Module* m = this; m && m->rightExpander.moduleId >= 0; m = m->rightExpander.module)
+				queued &= engineQueue.pushModuleBypass(m->rightExpander.moduleId, val);
+		}
+		if (mode == MODE_LEFTRIGHT || mode == MODE_LEFT) {
+			for (Module* m = this; m && m->leftExpander.moduleId >= 0; m = m->leftExpander.module)
+				queued &= engineQueue.pushModuleBypass(m->leftExpander.moduleId, val);
+		}
+		return queued;
+	}
+
 	/** 
 	 * Randomizes all modules of the current strip.
-	 * To be called from engine-thread only.
+	 * To be called from app-thread only.
 	 */
 	void groupRandomize(bool useHistory) {
 		//std::lock_guard<std::mutex> lockGuard(excludeMutex);
@@ -219,8 +238,6 @@ struct StripModule : Module {
 			Module* m = this;
 			while (true) {
 				if (!m || m->rightExpander.moduleId < 0) break;
-				// Be careful: this function is called from the dsp-thread, but widgets belong
-				// to the app-world!
 
 				history::ModuleChange* h;
 				if (useHistory) {
@@ -260,8 +277,6 @@ struct StripModule : Module {
 			Module* m = this;
 			while (true) {
 				if (!m || m->leftExpander.moduleId < 0) break;
-				// Be careful: this function is called from the dsp-thread, but widgets belong
-				// to the app-world!
 
 				history::ModuleChange* h;
 				if (useHistory) {
@@ -654,6 +669,14 @@ struct StripWidget : ThemedModuleWidget<StripModule> {
 		addParam(button);
 	}
 
+	void step() override {
+		if (module && module->randomizeRequested) {
+			module->randomizeRequested = false;
+			module->groupRandomize(module->randomizeUseHistory);
+		}
+		ThemedModuleWidget<StripModule>::step();
+	}
+
 	/**
 	 * Removes all modules in the group. Used for "cut" in cut & paste.
 	 */
@@ -909,16 +932,20 @@ struct StripWidget : ThemedModuleWidget<StripModule> {
 	 * Fixes parameter mappings within a preset. This can be considered a hack because
 	 * Rack v1 offers no API for reading the mapping module of a parameter. So this replaces the
 	 * module id in the preset JSON with the new module id to preserve correct mapping.
-	 * This means every module using mapping must be handled explicitly.
+	 * Mapping modules of this plugin are known by the mapping registry, modules of other
+	 * plugins must be handled explicitly.
 	 * @moduleJ json-representation of the module
 	 * @modules maps old module ids the new modules
 	 */
 	void groupFromJson_presets_fixMapping(json_t* moduleJ, std::map<int, ModuleWidget*>& modules) {
 		std::string pluginSlug = json_string_value(json_object_get(moduleJ, "plugin"));
 		std::string modelSlug = json_string_value(json_object_get(moduleJ, "model"));
+		int oldId = json_integer_value(json_object_get(moduleJ, "id"));
+		auto it = modules.find(oldId);
+		ModuleWidget* owner = it != modules.end() ? it->second : NULL;
 
-		// Only handle some specific modules known to use mapping of parameters
-		if (!( (pluginSlug == "Stoermelder-P1" && (modelSlug == "CVMap" || modelSlug == "CVMapMicro" || modelSlug == "CVPam" || modelSlug == "ReMoveLite" || modelSlug == "MidiCat"))
+		// Only handle modules known to use mapping of parameters
+		if (!( (owner != NULL && mappingRegistry.isOwner(owner->module))
 			|| (pluginSlug == "Core" && modelSlug == "MIDI-Map"))) 
 			return;
 
@@ -933,10 +960,11 @@ struct StripWidget : ThemedModuleWidget<StripModule> {
 					continue;
 				int oldId = json_integer_value(moduleIdJ);
 				if (oldId >= 0) {
+					// Mapped modules outside of the strip are not in the map, don't add them
 					int newId = -1;
-					ModuleWidget* mw = modules[oldId];
-					if (mw != NULL) {
-						newId = mw->module->id;
+					auto it = modules.find(oldId);
+					if (it != modules.end() && it->second != NULL) {
+						newId = it->second->module->id;
 					}
 					json_object_set_new(mapJ, "moduleId", json_integer(newId));
 				}
@@ -3,6 +3,15 @@
 #include <thread>
 
 
+/** Detects modules which apply the performance profile of pluginSettings to their dividers */
+template < typename MODULE >
+struct HasProfile {
+	template < typename T > static char test(decltype(&T::applyProfile));
+	template < typename T > static long test(...);
+	static const bool value = sizeof(test<MODULE>(0)) == sizeof(char);
+};
+
+
 template < typename MODULE, typename BASE = ModuleWidget >
 struct ThemedModuleWidget : BASE {
 	MODULE* module;
@@ -91,9 +100,90 @@ struct ThemedModuleWidget : BASE {
 			}
 		};
 
+		struct ProfileMenuItem : MenuItem {
+			ProfileMenuItem() {
+				rightText = RIGHT_ARROW;
+			}
+
+			Menu* createChildMenu() override {
+				struct ProfileItem : MenuItem {
+					PROFILE profile;
+
+					void onAction(const event::Action& e) override {
+						pluginSettings.setProfile(profile);
+						pluginSettings.saveToJson();
+					}
+					void step() override {
+						rightText = pluginSettings.profile == profile ? "✔" : "";
+						MenuItem::step();
+					}
+				};
+
+				Menu* menu = new Menu;
+				menu->addChild(createMenuLabel("Applies to all modules of this plugin with this menu"));
+				menu->addChild(construct<ProfileItem>(&MenuItem::text, "Live (low latency)", &ProfileItem::profile, PROFILE_LIVE));
+				menu->addChild(construct<ProfileItem>(&MenuItem::text, "Balanced", &ProfileItem::profile, PROFILE_BALANCED));
+				menu->addChild(construct<ProfileItem>(&MenuItem::text, "Render (eco)", &ProfileItem::profile, PROFILE_ECO));
+				return menu;
+			}
+		};
+
+		struct ProfilerMenuItem : MenuItem {
+			ProcessProfiler* profiler;
+
+			ProfilerMenuItem() {
+				rightText = RIGHT_ARROW;
+			}
+
+			Menu* createChildMenu() override {
+				struct EnabledItem : MenuItem {
+					ProcessProfiler* profiler;
+					void onAction(const event::Action& e) override {
+						profiler->setEnabled(!profiler->enabled);
+					}
+					void step() override {
+						rightText = profiler->enabled ? "✔" : "";
+						MenuItem::step();
+					}
+				};
+
+				struct SectionLabel : MenuLabel {
+					ProcessProfiler* profiler;
+					ProcessProfiler::Section section;
+					std::string name;
+					void step() override {
+						if (profiler->enabled) {
+							float avg = profiler->getAverage(section);
+							float p99 = profiler->getPercentile99(section);
+							text = string::f("%s: %.0f ns avg, %.0f ns p99", name.c_str(), avg, p99);
+						}
+						else {
+							text = name + ": -";
+						}
+						MenuLabel::step();
+					}
+				};
+
+				Menu* menu = new Menu;
+				menu->addChild(construct<EnabledItem>(&MenuItem::text, "Enabled", &EnabledItem::profiler, profiler));
+				menu->addChild(new MenuSeparator());
+				menu->addChild(construct<SectionLabel>(&SectionLabel::name, "Audio", &SectionLabel::profiler, profiler, &SectionLabel::section, ProcessProfiler::SECTION_AUDIO));
+				menu->addChild(construct<SectionLabel>(&SectionLabel::name, "Control", &SectionLabel::profiler, profiler, &SectionLabel::section, ProcessProfiler::SECTION_CONTROL));
+				menu->addChild(construct<SectionLabel>(&SectionLabel::name, "Lights", &SectionLabel::profiler, profiler, &SectionLabel::section, ProcessProfiler::SECTION_LIGHT));
+				return menu;
+			}
+		};
+
 		menu->addChild(construct<ManualItem>(&MenuItem::text, "Module Manual", &ManualItem::baseName, baseName));
 		menu->addChild(new MenuSeparator());
 		menu->addChild(construct<PanelMenuItem>(&MenuItem::text, "Panel", &PanelMenuItem::module, module));
+		if (HasProfile<MODULE>::value) {
+			menu->addChild(construct<ProfileMenuItem>(&MenuItem::text, "Performance profile"));
+		}
+		ProcessProfiler* profiler = ProcessProfiler::find(module);
+		if (profiler) {
+			menu->addChild(construct<ProfilerMenuItem>(&MenuItem::text, "CPU profiling", &ProfilerMenuItem::profiler, profiler));
+		}
 		BASE::appendContextMenu(menu);
 	}
 
@@ -102,6 +192,8 @@ struct ThemedModuleWidget : BASE {
 			BASE::panel->visible = module->panelTheme == 0;
 			darkPanel->visible  = module->panelTheme == 1;
 		}
+		// Apply engine changes queued by any module at this safe point on the app-thread
+		engineQueue.process();
 		BASE::step();
 	}
 };
@@ -1,45 +1,80 @@
 #pragma once
 
+/**
+ * Subdivides the period of a clock into a number of evenly spaced pulses.
+ * The phase is kept as an integer "samples * division - pulses * clock", so the n-th pulse
+ * is placed exactly on the first sample at or after n * clock / division without any drift.
+ */
 struct ClockMultiplier {
 	uint32_t clock = 0;
 	uint32_t lastTickSamples = 0;
-	float division = 0.f;
-	float divisionMult = 0.f;
-	uint32_t currentDivision = 0;
+	int32_t division = 0;
+	int32_t phase = 0;
 
 	bool process() {
 		lastTickSamples++;
-		if (division > 0 && currentDivision >= divisionMult) {
-			currentDivision++;
-			divisionMult += division;
-			return true;
-		}
-		currentDivision++;
-		return false;
+		bool r = division > 0 && phase >= 0;
+		if (r) phase -= (int32_t)clock;
+		phase += division;
+		return r;
 	}
 
 	void tick() {
 		clock = lastTickSamples;
 		lastTickSamples = 0;
-		division = 0.f;
-		divisionMult = 0.f;
-		currentDivision = 0;
+		division = 0;
+		phase = 0;
 	}
 
 	void trigger(uint32_t div) {
 		if (clock == 0) return;
-		division = 0.f;
-		divisionMult = 0.f;
-		if (div == 0) return;
-		division = clock / float(div);
+		division = div;
+		phase = 0;
 	}
 
 	void reset() {
 		clock = 0;
 		lastTickSamples = 0;
-		division = 0.f;
-		divisionMult = 0.f;
-		currentDivision = 0;
+		division = 0;
+		phase = 0;
+	}
+};
+
+
+/** ClockMultiplier for four independent clocks, each lane is one clock */
+struct ClockMultiplier4 {
+	simd::int32_4 clock = 0;
+	simd::int32_4 lastTickSamples = 0;
+	simd::int32_4 division = 0;
+	simd::int32_4 phase = 0;
+
+	/** Returns a bitmask of the lanes with a pulse on this sample */
+	inline int process() {
+		lastTickSamples += simd::int32_4(1);
+		simd::int32_4 r = (division > 0) & (phase > -1);
+		phase -= r & clock;
+		phase += division;
+		return simd::movemask(simd::float_4::cast(r));
+	}
+
+	void tick(int i) {
+		clock[i] = lastTickSamples[i];
+		lastTickSamples[i] = 0;
+		division[i] = 0;
+		phase[i] = 0;
+	}
+
+	void trigger(int i, uint32_t div) {
+		if (clock[i] == 0) return;
+		division[i] = div;
+		phase[i] = 0;
+	}
+
+	void reset(int i) {
+		clock[i] = 0;
+		lastTickSamples[i] = 0;
+		division[i] = 0;
+		phase[i] = 0;
 	}
 };
 
@@ -92,47 +127,66 @@ struct LinearFade {
 };
 
 
-struct LinearFade4 {
+/**
+ * Bank of N independent LinearFades sharing the same rise and fall times, stored as
+ * struct-of-arrays so four fades are advanced per instruction. N must be a multiple of 4.
+ */
+template < int N >
+struct LinearFadeBank {
+	static const int VECTORS = N / 4;
+
 	float rise = 1.f;
 	float fall = 1.f;
-	simd::float_4 currentRise;
-	simd::float_4 currentFall;
-	simd::float_4 last = 0.f;
+	simd::float_4 currentRise[VECTORS];
+	simd::float_4 currentFall[VECTORS];
+	simd::float_4 last[VECTORS];
+
+	LinearFadeBank() {
+		for (int i = 0; i < VECTORS; i++) {
+			currentRise[i] = rise;
+			currentFall[i] = 0.f;
+			last[i] = 0.f;
+		}
+	}
 
 	void reset(int i, float last) {
-		currentRise[i] = rise;
-		currentFall[i] = 0.f;
-		this->last[i] = last;
+		currentRise[i / 4][i % 4] = rise;
+		currentFall[i / 4][i % 4] = 0.f;
+		this->last[i / 4][i % 4] = last;
 	}
 
 	void triggerFadeIn(int i) {
-		currentRise[i] = (currentFall[i] / fall) * rise;
-		currentFall[i] = 0.f;
-		last[i] = 1.f;
+		currentRise[i / 4][i % 4] = (fall > 0.f ? (currentFall[i / 4][i % 4] / fall) : 0.f) * rise;
+		currentFall[i / 4][i % 4] = 0.f;
+		last[i / 4][i % 4] = 1.f;
 	}
 
 	void triggerFadeOut(int i) {
-		currentFall[i] = (currentRise[i] / rise) * fall;
-		currentRise[i] = rise;
-		last[i] = 0.f;
+		currentFall[i / 4][i % 4] = (rise > 0.f ? (currentRise[i / 4][i % 4] / rise) : 0.f) * fall;
+		currentRise[i / 4][i % 4] = rise;
+		last[i / 4][i % 4] = 0.f;
 	}
 
 	inline void setRiseFall(float rise, float fall) {
-		currentRise = simd::ifelse(currentRise == this->rise, rise, currentRise);
-		currentFall = simd::fmin(fall, currentFall);
+		for (int i = 0; i < VECTORS; i++) {
+			currentRise[i] = simd::ifelse(currentRise[i] == this->rise, rise, currentRise[i]);
+			currentFall[i] = simd::fmin(fall, currentFall[i]);
+		}
 		this->rise = rise;
 		this->fall = fall;
 	}
 
-	inline simd::float_4 process(float deltaTime) {
-		simd::float_4 r = last;
-
-		r = simd::ifelse(currentRise < rise, currentRise / rise, r);
-		currentRise = simd::ifelse(currentRise < rise, currentRise += deltaTime, currentRise);
-
-		r = simd::ifelse(currentFall > 0.f, currentFall / fall, r);
-		currentFall = simd::ifelse(currentFall > 0.f, simd::fmax(currentFall - deltaTime, 0.f), currentFall);
-
-		return r;
+	/** Advances all fades and stores their N values to out, same results as LinearFade::process() */
+	inline void process(float deltaTime, float* out) {
+		for (int i = 0; i < VECTORS; i++) {
+			simd::float_4 rising = currentRise[i] < rise;
+			currentRise[i] = simd::ifelse(rising, currentRise[i] + deltaTime, currentRise[i]);
+			simd::float_4 falling = ~rising & (currentFall[i] > 0.f);
+			currentFall[i] = simd::ifelse(falling, simd::fmax(currentFall[i] - deltaTime, 0.f), currentFall[i]);
+
+			simd::float_4 r = simd::ifelse(falling, currentFall[i] / fall, last[i]);
+			r = simd::ifelse(rising, currentRise[i] / rise, r);
+			r.store(&out[i * 4]);
+		}
 	}
-};
\ No newline at end of file
+};
@@ -0,0 +1,88 @@
+#include "rack.hpp"
+#include "enginequeue.hpp"
+
+
+EngineQueue engineQueue;
+
+
+EngineQueue::EngineQueue() {
+	for (size_t i = 0; i < SIZE; i++) {
+		cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	pushPos.store(0, std::memory_order_relaxed);
+}
+
+bool EngineQueue::push(const EngineCommand& command) {
+	size_t pos = pushPos.load(std::memory_order_relaxed);
+	while (true) {
+		Cell* cell = &cells[pos & (SIZE - 1)];
+		size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+		if (diff == 0) {
+			// Claim the cell, another producer might have been faster
+			if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				cell->command = command;
+				cell->sequence.store(pos + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if (diff < 0) {
+			// Queue is full
+			return false;
+		}
+		else {
+			pos = pushPos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+bool EngineQueue::pop(EngineCommand* command) {
+	Cell* cell = &cells[popPos & (SIZE - 1)];
+	size_t sequence = cell->sequence.load(std::memory_order_acquire);
+	if ((intptr_t)sequence - (intptr_t)(popPos + 1) < 0) {
+		// Queue is empty or the producer has not finished writing the cell yet
+		return false;
+	}
+	*command = cell->command;
+	cell->sequence.store(popPos + SIZE, std::memory_order_release);
+	popPos++;
+	return true;
+}
+
+bool EngineQueue::pushParamHandleUpdate(rack::engine::ParamHandle* paramHandle, int moduleId, int paramId, bool overwrite) {
+	EngineCommand command;
+	command.type = EngineCommand::PARAMHANDLE_UPDATE;
+	command.paramHandle = paramHandle;
+	command.moduleId = moduleId;
+	command.paramId = paramId;
+	command.flag = overwrite;
+	return push(command);
+}
+
+bool EngineQueue::pushModuleBypass(int moduleId, bool bypass) {
+	EngineCommand command;
+	command.type = EngineCommand::MODULE_BYPASS;
+	command.moduleId = moduleId;
+	command.flag = bypass;
+	return push(command);
+}
+
+void EngineQueue::process() {
+	EngineCommand command;
+	while (pop(&command)) {
+		apply(command);
+	}
+}
+
+void EngineQueue::apply(const EngineCommand& command) {
+	switch (command.type) {
+		case EngineCommand::PARAMHANDLE_UPDATE: {
+			APP->engine->updateParamHandle(command.paramHandle, command.moduleId, command.paramId, command.flag);
+		} break;
+		case EngineCommand::MODULE_BYPASS: {
+			// Modules might have been removed in the meantime
+			rack::engine::Module* m = APP->engine->getModule(command.moduleId);
+			if (m && m->bypass != command.flag) APP->engine->bypassModule(m, command.flag);
+		} break;
+	}
+}
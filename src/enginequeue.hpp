@@ -0,0 +1,56 @@
+#pragma once
+#include "rack.hpp"
+#include <atomic>
+
+
+struct EngineCommand {
+	enum Type {
+		PARAMHANDLE_UPDATE,
+		MODULE_BYPASS
+	};
+
+	Type type;
+	/** Used by PARAMHANDLE_UPDATE */
+	rack::engine::ParamHandle* paramHandle;
+	int moduleId;
+	int paramId;
+	/** Overwrite-flag for PARAMHANDLE_UPDATE, bypass-state for MODULE_BYPASS */
+	bool flag;
+};
+
+/**
+ * Lock-free queue for deferring mutations of the engine's state, such as updates of
+ * ParamHandles or bypassing modules. Commands can be pushed from any thread, including the
+ * engine's worker threads, and are applied in one batch by the app-thread when stepping the
+ * module widgets. Commands are never applied on the pushing thread, callers must retry
+ * commands which could not be queued.
+ * Modules must call process() before they delete any ParamHandle which might be queued.
+ */
+struct EngineQueue {
+	static const size_t SIZE = 1024;
+
+	struct Cell {
+		std::atomic<size_t> sequence;
+		EngineCommand command;
+	};
+
+	Cell cells[SIZE];
+	std::atomic<size_t> pushPos;
+	/** Only accessed by the app-thread */
+	size_t popPos = 0;
+
+	EngineQueue();
+
+	/** Returns false if the queue is full */
+	bool push(const EngineCommand& command);
+	bool pop(EngineCommand* command);
+
+	/** Returns false if the queue is full */
+	bool pushParamHandleUpdate(rack::engine::ParamHandle* paramHandle, int moduleId, int paramId, bool overwrite);
+	/** Returns false if the queue is full */
+	bool pushModuleBypass(int moduleId, bool bypass);
+
+	/** Applies all queued commands, to be called from the app-thread only */
+	void process();
+	void apply(const EngineCommand& command);
+};
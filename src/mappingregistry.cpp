@@ -0,0 +1,82 @@
+#include "rack.hpp"
+#include "mappingregistry.hpp"
+
+
+MappingRegistry mappingRegistry;
+
+
+void MappingRegistry::registerOwner(rack::engine::Module* owner) {
+	std::lock_guard<std::mutex> lock(mutex);
+	owners.insert(owner);
+}
+
+void MappingRegistry::unregisterOwner(rack::engine::Module* owner) {
+	std::lock_guard<std::mutex> lock(mutex);
+	owners.erase(owner);
+	for (auto it = entries.begin(); it != entries.end(); ) {
+		if (it->second.owner == owner) {
+			handleKeys.erase(it->second.paramHandle);
+			it = entries.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+}
+
+bool MappingRegistry::isOwner(rack::engine::Module* owner) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return owners.find(owner) != owners.end();
+}
+
+void MappingRegistry::update(rack::engine::Module* owner, int slot, rack::engine::ParamHandle* paramHandle) {
+	std::lock_guard<std::mutex> lock(mutex);
+	removeLocked(paramHandle);
+	if (paramHandle->moduleId < 0)
+		return;
+
+	Key key = Key(paramHandle->moduleId, paramHandle->paramId);
+	// The parameter has been learned twice, the engine has already unbound the previous handle
+	auto it = entries.find(key);
+	if (it != entries.end())
+		handleKeys.erase(it->second.paramHandle);
+
+	MappingEntry entry;
+	entry.owner = owner;
+	entry.slot = slot;
+	entry.paramHandle = paramHandle;
+	entries[key] = entry;
+	handleKeys[paramHandle] = key;
+}
+
+void MappingRegistry::remove(rack::engine::ParamHandle* paramHandle) {
+	std::lock_guard<std::mutex> lock(mutex);
+	removeLocked(paramHandle);
+}
+
+void MappingRegistry::removeLocked(rack::engine::ParamHandle* paramHandle) {
+	auto it = handleKeys.find(paramHandle);
+	if (it == handleKeys.end())
+		return;
+	entries.erase(it->second);
+	handleKeys.erase(it);
+}
+
+bool MappingRegistry::isValid(const Key& key, const MappingEntry& entry) {
+	return entry.paramHandle->moduleId == key.first && entry.paramHandle->paramId == key.second;
+}
+
+bool MappingRegistry::find(int moduleId, int paramId, MappingEntry* entry) {
+	std::lock_guard<std::mutex> lock(mutex);
+	Key key = Key(moduleId, paramId);
+	auto it = entries.find(key);
+	if (it == entries.end())
+		return false;
+	if (!isValid(key, it->second)) {
+		handleKeys.erase(it->second.paramHandle);
+		entries.erase(it);
+		return false;
+	}
+	*entry = it->second;
+	return true;
+}
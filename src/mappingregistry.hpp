@@ -0,0 +1,48 @@
+#pragma once
+#include "rack.hpp"
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <mutex>
+
+
+struct MappingEntry {
+	/** The module owning the mapping */
+	rack::engine::Module* owner;
+	/** Slot of the mapping within its owner */
+	int slot;
+	rack::engine::ParamHandle* paramHandle;
+};
+
+/**
+ * Plugin-wide reverse index of all parameters mapped by modules of this plugin, keyed on
+ * the mapped moduleId and paramId. Modules must call update() after binding or unbinding
+ * a ParamHandle and unregisterOwner() before they are destroyed.
+ * As the engine might unbind handles on its own, e.g. when another handle takes over the
+ * parameter or the mapped module gets removed, entries are validated on every lookup.
+ * To be used from the app-thread.
+ */
+struct MappingRegistry {
+	typedef std::pair<int, int> Key;
+
+	std::map<Key, MappingEntry> entries;
+	std::unordered_map<rack::engine::ParamHandle*, Key> handleKeys;
+	std::set<rack::engine::Module*> owners;
+	std::mutex mutex;
+
+	void registerOwner(rack::engine::Module* owner);
+	/** Removes the owner and all of its mappings */
+	void unregisterOwner(rack::engine::Module* owner);
+	bool isOwner(rack::engine::Module* owner);
+
+	/** Reindexes a handle after it has been bound or unbound */
+	void update(rack::engine::Module* owner, int slot, rack::engine::ParamHandle* paramHandle);
+	void remove(rack::engine::ParamHandle* paramHandle);
+
+	/** Returns false if the parameter is not mapped by any module of this plugin */
+	bool find(int moduleId, int paramId, MappingEntry* entry);
+
+private:
+	void removeLocked(rack::engine::ParamHandle* paramHandle);
+	bool isValid(const Key& key, const MappingEntry& entry);
+};
@@ -1,6 +1,9 @@
 #include "rack.hpp"
 #include "components.hpp"
 #include "pluginsettings.hpp"
+#include "enginequeue.hpp"
+#include "mappingregistry.hpp"
+#include "profiler.hpp"
 
 using namespace rack;
 
@@ -9,6 +12,10 @@ extern Plugin* pluginInstance;
 
 extern StoermelderSettings pluginSettings;
 
+extern EngineQueue engineQueue;
+
+extern MappingRegistry mappingRegistry;
+
 extern Model* modelCVMap;
 extern Model* modelCVMapMicro;
 extern Model* modelCVPam;
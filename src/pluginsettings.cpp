@@ -4,10 +4,39 @@
 
 StoermelderSettings pluginSettings;
 
+static const char* profileNames[] = { "live-low-latency", "balanced", "render-eco" };
+
+
+void StoermelderSettings::setProfile(PROFILE profile) {
+    this->profile = profile;
+    profileRevision++;
+}
+
+int StoermelderSettings::controlDivision(int division) {
+    // Divisions are kept at powers of two if they already are
+    switch (profile) {
+        case PROFILE_LIVE:
+            return std::max(division / 4, 1);
+        case PROFILE_ECO:
+            return division * 4;
+        default:
+            return division;
+    }
+}
+
+int StoermelderSettings::lightDivision(int division) {
+    switch (profile) {
+        case PROFILE_ECO:
+            return division * 4;
+        default:
+            return division;
+    }
+}
 
 void StoermelderSettings::saveToJson() {
     json_t* settingsJ = json_object();
     json_object_set_new(settingsJ, "panelThemeDefault", json_integer(panelThemeDefault));
+    json_object_set_new(settingsJ, "profile", json_string(profileNames[profile]));
 
     std::string settingsFilename = rack::asset::user("Stoermelder-P1.json");
     FILE* file = fopen(settingsFilename.c_str(), "w");
@@ -38,6 +67,14 @@ void StoermelderSettings::readFromJson() {
     json_t* panelThemeDefaultJ = json_object_get(settingsJ, "panelThemeDefault");
     if (panelThemeDefaultJ) panelThemeDefault = json_integer_value(panelThemeDefaultJ);
 
+    json_t* profileJ = json_object_get(settingsJ, "profile");
+    if (profileJ) {
+        const char* name = json_string_value(profileJ);
+        for (int i = 0; name && i < 3; i++) {
+            if (std::string(name) == profileNames[i]) setProfile((PROFILE)i);
+        }
+    }
+
     fclose(file);
     json_decref(settingsJ);
 }
\ No newline at end of file
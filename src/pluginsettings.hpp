@@ -1,9 +1,25 @@
 #pragma once
 
 
+enum PROFILE {
+	PROFILE_LIVE = 0,
+	PROFILE_BALANCED = 1,
+	PROFILE_ECO = 2
+};
+
 struct StoermelderSettings {
 	int panelThemeDefault = 0;
+	/** Trades control latency for CPU, applied to the clock dividers of all modules */
+	PROFILE profile = PROFILE_BALANCED;
+	/** Incremented on every change of the profile, modules reapply their dividers when it changes */
+	int profileRevision = 0;
+
+	void setProfile(PROFILE profile);
+	/** Returns the division of a control-rate divider for the current profile */
+	int controlDivision(int division);
+	/** Returns the division of a light divider for the current profile */
+	int lightDivision(int division);
 
 	void saveToJson();
 	void readFromJson();
-};
\ No newline at end of file
+};
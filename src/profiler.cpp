@@ -0,0 +1,91 @@
+#include "rack.hpp"
+#include "profiler.hpp"
+#include <map>
+#include <mutex>
+
+
+static std::map<rack::engine::Module*, ProcessProfiler*> profilers;
+static std::mutex profilersMutex;
+
+
+ProcessProfiler::ProcessProfiler() {
+	reset();
+}
+
+ProcessProfiler::~ProcessProfiler() {
+	std::lock_guard<std::mutex> lock(profilersMutex);
+	for (auto it = profilers.begin(); it != profilers.end(); it++) {
+		if (it->second == this) {
+			profilers.erase(it);
+			break;
+		}
+	}
+}
+
+void ProcessProfiler::attach(rack::engine::Module* module) {
+	std::lock_guard<std::mutex> lock(profilersMutex);
+	profilers[module] = this;
+}
+
+ProcessProfiler* ProcessProfiler::find(rack::engine::Module* module) {
+	std::lock_guard<std::mutex> lock(profilersMutex);
+	auto it = profilers.find(module);
+	return it != profilers.end() ? it->second : NULL;
+}
+
+void ProcessProfiler::record(Section section, int64_t ns) {
+	Stats* s = &stats[section];
+	if (ns < 1) ns = 1;
+	// Half-octave bins: the position of the highest bit and the bit below it
+	int msb = 63 - __builtin_clzll((uint64_t)ns);
+	int bin = 2 * msb + (msb > 0 ? (ns >> (msb - 1)) & 1 : 0);
+	bin = std::min(bin, BINS - 1);
+	s->bins[bin].store(s->bins[bin].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+	uint32_t count = s->count.load(std::memory_order_relaxed);
+	float average = s->average.load(std::memory_order_relaxed);
+	// Exponential moving average over about 1000 calls, plain mean until then
+	float alpha = count < 1000 ? 1.f / (count + 1) : 1e-3f;
+	s->average.store(average + alpha * (ns - average), std::memory_order_relaxed);
+	s->count.store(count + 1, std::memory_order_relaxed);
+}
+
+void ProcessProfiler::reset() {
+	for (int i = 0; i < NUM_SECTIONS; i++) {
+		stats[i].average.store(0.f);
+		stats[i].count.store(0);
+		for (int j = 0; j < BINS; j++) {
+			stats[i].bins[j].store(0);
+		}
+	}
+}
+
+void ProcessProfiler::setEnabled(bool enabled) {
+	if (enabled) reset();
+	this->enabled.store(enabled);
+}
+
+float ProcessProfiler::getAverage(Section section) {
+	return stats[section].average.load(std::memory_order_relaxed);
+}
+
+float ProcessProfiler::getPercentile99(Section section) {
+	Stats* s = &stats[section];
+	uint64_t total = 0;
+	for (int i = 0; i < BINS; i++) {
+		total += s->bins[i].load(std::memory_order_relaxed);
+	}
+	if (total == 0)
+		return 0.f;
+	uint64_t threshold = total - total / 100;
+	uint64_t sum = 0;
+	for (int i = 0; i < BINS; i++) {
+		sum += s->bins[i].load(std::memory_order_relaxed);
+		if (sum >= threshold) {
+			// Upper bound of the half-octave bin
+			int msb = i / 2;
+			return (float)(1ull << msb) * (i % 2 == 0 ? 1.5f : 2.f);
+		}
+	}
+	return 0.f;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "rack.hpp"
+#include <atomic>
+#include <chrono>
+
+
+/**
+ * Opt-in timing of the sections of a module's process() method. Modules own a profiler,
+ * attach it in their constructor and wrap their sections with begin() and end(). While
+ * disabled every section costs a single relaxed load of the enabled-flag.
+ * Timings are collected by the engine-thread and read by the app-thread for display.
+ */
+struct ProcessProfiler {
+	enum Section {
+		SECTION_AUDIO = 0,
+		SECTION_CONTROL = 1,
+		SECTION_LIGHT = 2,
+		NUM_SECTIONS
+	};
+
+	/** Histogram bins in half-octaves of nanoseconds */
+	static const int BINS = 64;
+
+	struct Stats {
+		std::atomic<float> average;
+		std::atomic<uint32_t> count;
+		std::atomic<uint32_t> bins[BINS];
+	};
+
+	std::atomic<bool> enabled{false};
+	Stats stats[NUM_SECTIONS];
+
+	ProcessProfiler();
+	~ProcessProfiler();
+
+	/** Makes the profiler available in the context menu of the module */
+	void attach(rack::engine::Module* module);
+	static ProcessProfiler* find(rack::engine::Module* module);
+
+	inline int64_t begin() {
+		if (!enabled.load(std::memory_order_relaxed))
+			return 0;
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	inline void end(Section section, int64_t start) {
+		if (start == 0)
+			return;
+		int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		record(section, now - start);
+	}
+
+	void record(Section section, int64_t ns);
+	void reset();
+	void setEnabled(bool enabled);
+
+	/** Moving average in nanoseconds */
+	float getAverage(Section section);
+	/** Upper bound of the 99th percentile in nanoseconds, 0 if nothing has been recorded */
+	float getPercentile99(Section section);
+};
@@ -0,0 +1,286 @@
+// Regression tests of DSP building blocks of the plugin. Only the headers of the Rack SDK are
+// used, neither the engine nor the app are running. Returns a non-zero exit code on failure.
+// The mapping modules (CV-MAP, CV-PAM, MIDI-CAT) are not covered, their process() needs a
+// running engine to resolve the ParamHandles.
+
+#include "rack.hpp"
+#include <cstdio>
+#include <random>
+
+using namespace rack;
+
+#include "digital.hpp"
+#include "ReMoveStorage.hpp"
+
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+		failures++; \
+	} \
+} while (0)
+
+
+// The vectorized building blocks must give the same results as their scalar counterparts on
+// every lane, bit for bit, for any sequence of triggers and parameter changes.
+
+static void testLinearFadeBank() {
+	const int N = 8;
+	const float sampleTime = 1.f / 48000.f;
+	std::minstd_rand rand(1);
+
+	LinearFade fades[N];
+	LinearFadeBank<N> bank;
+	for (int i = 0; i < N; i++) {
+		fades[i].reset(i % 2);
+		bank.reset(i, i % 2);
+	}
+
+	alignas(16) float out[N];
+	int mismatches = 0;
+	for (int n = 0; n < 48000; n++) {
+		int r = rand() % 1000;
+		int i = rand() % N;
+		if (r < 20) {
+			fades[i].triggerFadeIn();
+			bank.triggerFadeIn(i);
+		}
+		else if (r < 40) {
+			fades[i].triggerFadeOut();
+			bank.triggerFadeOut(i);
+		}
+		else if (r == 40) {
+			fades[i].reset(0.5f);
+			bank.reset(i, 0.5f);
+		}
+		else if (r == 41) {
+			// Changes during running fades, including zero times
+			float rise = (rand() % 5) * 0.005f;
+			float fall = (rand() % 5) * 0.005f;
+			for (int k = 0; k < N; k++) fades[k].setRiseFall(rise, fall);
+			bank.setRiseFall(rise, fall);
+		}
+
+		bank.process(sampleTime, out);
+		for (int k = 0; k < N; k++) {
+			float v = fades[k].process(sampleTime);
+			if (!(v == out[k] || (std::isnan(v) && std::isnan(out[k])))) mismatches++;
+		}
+	}
+	CHECK(mismatches == 0);
+}
+
+static void testClockMultiplier4() {
+	std::minstd_rand rand(2);
+
+	ClockMultiplier clocks[4];
+	ClockMultiplier4 bank;
+	int period[4] = {};
+	int counter[4] = {};
+
+	int mismatches = 0;
+	int pulses = 0;
+	for (int n = 0; n < 200000; n++) {
+		for (int i = 0; i < 4; i++) {
+			// Clocks change their period now and then, triggers come with any division
+			if (period[i] == 0 || rand() % 20000 == 0) period[i] = 100 + rand() % 5000;
+			if (++counter[i] >= period[i]) {
+				counter[i] = 0;
+				clocks[i].tick();
+				bank.tick(i);
+				if (rand() % 4 != 0) {
+					uint32_t div = 1 + rand() % 16;
+					clocks[i].trigger(div);
+					bank.trigger(i, div);
+				}
+			}
+			if (rand() % 50000 == 0) {
+				clocks[i].reset();
+				bank.reset(i);
+			}
+		}
+
+		int mask = bank.process();
+		for (int i = 0; i < 4; i++) {
+			bool p = clocks[i].process();
+			if (p != (bool)(mask & (1 << i))) mismatches++;
+			if (p) pulses++;
+		}
+	}
+	CHECK(mismatches == 0);
+	// Make sure the comparison was not trivial
+	CHECK(pulses > 1000);
+}
+
+
+namespace ReMove {
+
+/** Fills one lane of sequence 0 with the given samples */
+static void fill(ReMoveStorage& storage, const std::vector<float>& samples, int lanes, int lane) {
+	for (size_t i = 0; i < samples.size(); i++) {
+		storage.reserve(0, i * lanes + lane);
+		storage.set(0, i * lanes + lane, samples[i]);
+	}
+}
+
+static int decode(const std::vector<uint8_t>& buffer, ReMoveStorage& storage, int lanes, int lane) {
+	const uint8_t* p = buffer.data();
+	return seqDecode(p, p + buffer.size(), storage, 0, lanes, lane);
+}
+
+static void testEncodeFixedVector() {
+	// Held values, a full-range jump and steps down, quantized to 0, 65535, 32768 and 16384
+	std::vector<float> samples = {0.f, 0.f, 0.f, 1.f, 0.5f, 0.5f, 0.25f};
+	std::vector<uint8_t> expected = {
+		0x07,             // length
+		0x00, 0x03,       // delta 0, run of 3
+		0xfe, 0xff, 0x07, // delta +65535
+		0xfd, 0xff, 0x03, // delta -32767
+		0x00, 0x01,       // delta 0, run of 1
+		0xff, 0xff, 0x01  // delta -16384
+	};
+
+	ReMoveStorage storage;
+	fill(storage, samples, 1, 0);
+	std::vector<uint8_t> buffer;
+	seqEncode(buffer, storage, 0, samples.size(), 1, 0);
+	CHECK(buffer == expected);
+
+	ReMoveStorage decoded;
+	CHECK(decode(expected, decoded, 1, 0) == (int)samples.size());
+	const int32_t quantized[] = {0, 0, 0, 65535, 32768, 32768, 16384};
+	for (size_t i = 0; i < samples.size(); i++) {
+		CHECK(decoded.get(0, i) == quantized[i] / 65535.f);
+	}
+}
+
+static void testRoundTripLanes() {
+	// Two interleaved lanes, a ramp with a plateau and an alternating pattern
+	const int lanes = 2;
+	const int length = 3 * REMOVE_CHUNK_SIZE + 17;
+	std::vector<float> ramp(length), alternating(length);
+	for (int i = 0; i < length; i++) {
+		ramp[i] = i < length / 2 ? (float)i / length : 0.5f;
+		alternating[i] = (i / 3) % 2 ? 0.875f : 0.125f;
+	}
+
+	ReMoveStorage storage;
+	storage.setLanes(lanes);
+	fill(storage, ramp, lanes, 0);
+	fill(storage, alternating, lanes, 1);
+	std::vector<uint8_t> buffer;
+	seqEncode(buffer, storage, 0, length, lanes, 0);
+	seqEncode(buffer, storage, 0, length, lanes, 1);
+
+	ReMoveStorage decoded;
+	decoded.setLanes(lanes);
+	const uint8_t* p = buffer.data();
+	const uint8_t* end = p + buffer.size();
+	CHECK(seqDecode(p, end, decoded, 0, lanes, 0) == length);
+	CHECK(seqDecode(p, end, decoded, 0, lanes, 1) == length);
+	CHECK(p == end);
+
+	// Decoding is exact on quantized values, so the error is at most half a quantization step
+	float maxError = 0.f;
+	for (int i = 0; i < length * lanes; i++) {
+		CHECK(decoded.get(0, i) == seqQuantize(storage.get(0, i)) / 65535.f);
+		maxError = std::max(maxError, std::fabs(decoded.get(0, i) - storage.get(0, i)));
+	}
+	CHECK(maxError <= 0.5f / 65535.f + 1e-7f);
+}
+
+static void testDecodeMalformed() {
+	ReMoveStorage storage;
+	// Truncated within a varint
+	CHECK(decode({0x07, 0x00, 0x03, 0xfe, 0xff}, storage, 1, 0) == -1);
+	// Fewer samples than the length
+	CHECK(decode({0x03, 0x02}, storage, 1, 0) == -1);
+	// Run exceeding the length
+	CHECK(decode({0x02, 0x00, 0x03}, storage, 1, 0) == -1);
+	// Run of zero samples
+	CHECK(decode({0x02, 0x00, 0x00, 0x00, 0x02}, storage, 1, 0) == -1);
+	// Value below 0
+	CHECK(decode({0x01, 0x01}, storage, 1, 0) == -1);
+	// Length exceeding REMOVE_MAX_DATA
+	CHECK(decode({0x81, 0x80, 0x04, 0x00, 0x81, 0x80, 0x04}, storage, 1, 0) == -1);
+	// Empty sequence
+	CHECK(decode({0x00}, storage, 1, 0) == 0);
+}
+
+static void testDecodeBudget() {
+	// A sequence of REMOVE_MAX_DATA samples does not fit next to another sequence, the
+	// samples exceeding the budget are skipped but the input is consumed completely
+	std::vector<uint8_t> buffer = {0x80, 0x80, 0x04, 0x00, 0x80, 0x80, 0x04};
+	ReMoveStorage storage;
+	storage.reserve(1, 0);
+	const uint8_t* p = buffer.data();
+	CHECK(seqDecode(p, p + buffer.size(), storage, 0, 1, 0) == REMOVE_MAX_DATA - REMOVE_CHUNK_SIZE);
+	CHECK(p == buffer.data() + buffer.size());
+}
+
+static int poolCount(ReMoveStorage& storage) {
+	int n = 0;
+	for (int c = 0; c < REMOVE_POOL_SIZE; c++) if (storage.pool[c].load()) n++;
+	return n;
+}
+
+static void testStoragePool() {
+	// A storage used by process() only takes chunks from the pool and hands them back
+	ReMoveStorage storage;
+	storage.allocate = false;
+	CHECK(!storage.reserve(0, 0));
+	storage.fill(2);
+	CHECK(poolCount(storage) == 2);
+	CHECK(storage.reserve(0, 0));
+	CHECK(storage.reserve(0, REMOVE_CHUNK_SIZE));
+	CHECK(!storage.reserve(0, 2 * REMOVE_CHUNK_SIZE));
+	CHECK(storage.chunkCount == 2 && poolCount(storage) == 0);
+	storage.set(0, REMOVE_CHUNK_SIZE, 0.5f);
+	CHECK(storage.peek(0, REMOVE_CHUNK_SIZE) == 0.5f);
+
+	storage.trim(0, 1);
+	CHECK(storage.chunkCount == 1 && poolCount(storage) == 1);
+	CHECK(storage.peek(0, REMOVE_CHUNK_SIZE) == 0.f);
+	storage.clear(0);
+	CHECK(storage.chunkCount == 0 && poolCount(storage) == 2);
+	// Chunks exceeding the spare count are freed
+	storage.fill(1);
+	CHECK(poolCount(storage) == 1);
+
+	// The pool never holds more chunks than fit next to the sequences
+	storage.fill(REMOVE_POOL_SIZE + 1);
+	CHECK(poolCount(storage) == REMOVE_POOL_SIZE);
+}
+
+static void testInterpolate() {
+	CHECK(seqInterpolate(INTERPOLATION_NONE, 0.f, 0.25f, 0.75f, 1.f, 0.5f) == 0.25f);
+	CHECK(seqInterpolate(INTERPOLATION_LINEAR, 0.f, 0.25f, 0.75f, 1.f, 0.5f) == 0.5f);
+	// Catmull-Rom passes through y1 and y2 and is exact on linear data
+	CHECK(seqInterpolate(INTERPOLATION_CUBIC, 0.f, 0.25f, 0.5f, 0.75f, 0.f) == 0.25f);
+	CHECK(seqInterpolate(INTERPOLATION_CUBIC, 0.f, 0.25f, 0.5f, 0.75f, 1.f) == 0.5f);
+	CHECK(std::fabs(seqInterpolate(INTERPOLATION_CUBIC, 0.f, 0.25f, 0.5f, 0.75f, 0.5f) - 0.375f) < 1e-6f);
+	// Overshoot is clamped
+	CHECK(seqInterpolate(INTERPOLATION_CUBIC, 0.f, 1.f, 1.f, 0.f, 0.5f) == 1.f);
+}
+
+} // namespace ReMove
+
+
+int main() {
+	testLinearFadeBank();
+	testClockMultiplier4();
+	ReMove::testEncodeFixedVector();
+	ReMove::testRoundTripLanes();
+	ReMove::testDecodeMalformed();
+	ReMove::testDecodeBudget();
+	ReMove::testStoragePool();
+	ReMove::testInterpolate();
+	if (failures > 0) {
+		printf("%d checks failed\n", failures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}